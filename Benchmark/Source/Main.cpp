@@ -0,0 +1,531 @@
+/*
+  ==============================================================================
+
+    This file contains the benchmark of the DSP engine. Every result is
+    written to stdout as one JSON object per line.
+
+    Usage: MultiBandCompressorBenchmark [--quick] [--seconds <audio seconds per case>]
+           MultiBandCompressorBenchmark --audit [--quick]
+           MultiBandCompressorBenchmark --golden <directory> [--record] [--tolerance <linear error>]
+           MultiBandCompressorBenchmark --memory [--instances <count>] [--editors]
+           MultiBandCompressorBenchmark --startup [--instances <count>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../JuceLibraryCode/JucePluginDefines.h"
+#include "../../Source/PluginProcessor.h"
+#include "RealtimeAudit.h"
+#include "RegressionTests.h"
+
+#if JUCE_LINUX
+ #include <malloc.h>
+#endif
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+// A parameter regime and the input level that puts the compressor in it
+struct Regime
+{
+    const char* name;
+    float threshold;
+    float ratio;
+    float kneeWidth;
+    float inputLevelDb;
+};
+
+static const Regime regimes[] =
+{
+    { "belowThreshold", -10.0f, 4.0f,  5.0f, -40.0f },
+    { "inKnee",         -20.0f, 4.0f, 10.0f, -20.0f },
+    { "heavy",          -60.0f, 10.0f, 5.0f,  -6.0f },
+};
+
+struct Result
+{
+    double nsPerSample;
+    double realtimeFactor;
+};
+
+//==============================================================================
+static void fillSignal(AudioSampleBuffer& buffer, double sampleRate, float levelDb, Random& random)
+{
+    // A 1 kHz sine with a little noise, so every band has something to compress
+    const float amplitude = Decibels::decibelsToGain(levelDb);
+    for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+    {
+        float* data = buffer.getWritePointer(channel);
+        for (int i = 0; i < buffer.getNumSamples(); i++)
+            data[i] = amplitude * (0.8f * (float) sin(MathConstants<double>::twoPi * 1000.0 * i / sampleRate)
+                                 + 0.2f * (random.nextFloat() * 2.0f - 1.0f));
+    }
+}
+
+// Runs process() over blocks of the signal until audioSeconds of audio went through it
+template <typename ProcessFunction>
+static Result measure(AudioSampleBuffer& signal, int blockSize, double sampleRate, double audioSeconds, ProcessFunction process)
+{
+    const int numChannels = signal.getNumChannels();
+    const int numBlocks = jmax(1, signal.getNumSamples() / blockSize);
+    const int64 totalBlocks = jmax((int64) 1, (int64) (audioSeconds * sampleRate / blockSize));
+
+    AudioSampleBuffer block(numChannels, blockSize);
+    auto copyBlock = [&] (int64 index)
+    {
+        const int offset = (int) (index % numBlocks) * blockSize;
+        for (int channel = 0; channel < numChannels; channel++)
+            block.copyFrom(channel, 0, signal, channel, offset, blockSize);
+    };
+
+    // Warm up caches and smoothers before timing
+    for (int64 i = 0; i < jmin((int64) 16, totalBlocks); i++)
+    {
+        copyBlock(i);
+        process(block);
+    }
+
+    int64 processingTicks = 0;
+    for (int64 i = 0; i < totalBlocks; i++)
+    {
+        copyBlock(i);
+        const int64 start = Time::getHighResolutionTicks();
+        process(block);
+        processingTicks += Time::getHighResolutionTicks() - start;
+    }
+
+    const double seconds = Time::highResolutionTicksToSeconds(processingTicks);
+    const double numSamples = (double) totalBlocks * blockSize;
+    return { seconds * 1.0e9 / numSamples, seconds > 0 ? numSamples / sampleRate / seconds : 0.0 };
+}
+
+static void report(const String& target, double sampleRate, int blockSize, int numChannels, const Regime& regime, const Result& result)
+{
+    DynamicObject::Ptr line = new DynamicObject();
+    line->setProperty("target", target);
+    line->setProperty("version", JucePlugin_VersionString);
+    line->setProperty("sampleRate", sampleRate);
+    line->setProperty("blockSize", blockSize);
+    line->setProperty("channels", numChannels);
+    line->setProperty("regime", regime.name);
+    line->setProperty("nsPerSample", result.nsPerSample);
+    line->setProperty("realtimeFactor", result.realtimeFactor);
+
+    cout << JSON::toString(var(line.get()), true) << endl;
+}
+
+static void setParameter(MultiBandCompressorAudioProcessor& processor, const String& parameterID, float value)
+{
+    if (auto* parameter = processor.parameters.getParameter(parameterID))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+//==============================================================================
+static void benchmarkCompressor(double sampleRate, int blockSize, int numChannels, const Regime& regime, AudioSampleBuffer& signal, double audioSeconds)
+{
+    Compressor compressor;
+    compressor.prepareToPlay(sampleRate, blockSize, numChannels);
+    compressor.setParameters(regime.ratio, regime.threshold, 10.0f, 50.0f, 1.0f, regime.kneeWidth);
+
+    report("compressor", sampleRate, blockSize, numChannels, regime,
+           measure(signal, blockSize, sampleRate, audioSeconds, [&] (AudioSampleBuffer& block) { compressor.processBlock(block); }));
+}
+
+static void benchmarkCrossover(double sampleRate, int blockSize, int numChannels, const Regime& regime, AudioSampleBuffer& signal, double audioSeconds)
+{
+    Crossover crossover;
+    crossover.prepare(sampleRate, numChannels);
+    crossover.setCutoffs(450.0f, 2500.0f);
+
+    AudioSampleBuffer low(numChannels, blockSize), mid(numChannels, blockSize), high(numChannels, blockSize);
+
+    report("crossover", sampleRate, blockSize, numChannels, regime,
+           measure(signal, blockSize, sampleRate, audioSeconds, [&] (AudioSampleBuffer& block)
+           {
+               for (int channel = 0; channel < numChannels; channel++)
+               {
+                   low.copyFrom(channel, 0, block, channel, 0, blockSize);
+                   mid.copyFrom(channel, 0, block, channel, 0, blockSize);
+                   high.copyFrom(channel, 0, block, channel, 0, blockSize);
+               }
+
+               crossover.process(low, mid, high, numChannels, blockSize);
+           }));
+}
+
+static void applyRegime(MultiBandCompressorAudioProcessor& processor, const Regime& regime)
+{
+    for (auto band : { "low", "mid", "high" })
+    {
+        setParameter(processor, String(band) + "Thresh", regime.threshold);
+        setParameter(processor, String(band) + "Ratio", regime.ratio);
+        setParameter(processor, String(band) + "Attack", 10.0f);
+        setParameter(processor, String(band) + "Release", 50.0f);
+    }
+    setParameter(processor, "kneeWidth", regime.kneeWidth);
+}
+
+// The processor on its processing grid, or with the grid off (gridSize 0). With automate, a threshold moves every block,
+// so every block is split on the grid lines, as it is while the host automates a parameter.
+static void benchmarkProcessor(const String& target, int gridSize, bool automate, double sampleRate, int blockSize, int numChannels,
+                               const Regime& regime, AudioSampleBuffer& signal, double audioSeconds)
+{
+    MultiBandCompressorAudioProcessor processor;
+    processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    processor.setProcessingGridSize(gridSize);
+    applyRegime(processor, regime);
+
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    MidiBuffer midi;
+    int64 blockIndex = 0;
+    report(target, sampleRate, blockSize, numChannels, regime,
+           measure(signal, blockSize, sampleRate, audioSeconds, [&] (AudioSampleBuffer& block)
+           {
+               if (automate)
+                   setParameter(processor, "lowThresh", regime.threshold - (float) (blockIndex++ % 2));
+
+               processor.processBlock(block, midi);
+           }));
+
+   #if MBC_ENABLE_PROFILING
+    cerr << processor.getProfiler().getReport();
+   #endif
+
+    processor.releaseResources();
+}
+
+// A surround stem through one instance, against the stereo instances it would otherwise take
+static void benchmarkSurround(double sampleRate, int blockSize, const AudioChannelSet& layout, const Regime& regime, AudioSampleBuffer& signal, double audioSeconds)
+{
+    auto makeProcessor = [&] (const AudioChannelSet& channels)
+    {
+        auto processor = make_unique<MultiBandCompressorAudioProcessor>();
+        AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add(channels);
+        buses.outputBuses.add(channels);
+        processor->setBusesLayout(buses);
+        processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+        applyRegime(*processor, regime);
+        processor->prepareToPlay(sampleRate, blockSize);
+        return processor;
+    };
+
+    const int numChannels = layout.size();
+    MidiBuffer midi;
+
+    auto surround = makeProcessor(layout);
+    report("processorSurround", sampleRate, blockSize, numChannels, regime,
+           measure(signal, blockSize, sampleRate, audioSeconds, [&] (AudioSampleBuffer& block) { surround->processBlock(block, midi); }));
+
+    vector<unique_ptr<MultiBandCompressorAudioProcessor>> pairs;
+    for (int channel = 0; channel < numChannels; channel += 2)
+        pairs.push_back(makeProcessor(AudioChannelSet::stereo()));
+
+    report("stereoInstances", sampleRate, blockSize, numChannels, regime,
+           measure(signal, blockSize, sampleRate, audioSeconds, [&] (AudioSampleBuffer& block)
+           {
+               for (size_t pair = 0; pair < pairs.size(); pair++)
+               {
+                   AudioSampleBuffer channels(block.getArrayOfWritePointers() + 2 * pair, 2, blockSize);
+                   pairs[pair]->processBlock(channels, midi);
+               }
+           }));
+}
+
+//==============================================================================
+// Drives processBlock with the real-time audit armed, changing every parameter, the A/B slot, the morph
+// and the preset between blocks
+static void auditProcessor(double sampleRate, int blockSize, AudioSampleBuffer& signal, Random& random)
+{
+    const int numChannels = signal.getNumChannels();
+
+    MultiBandCompressorAudioProcessor processor;
+    processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+    processor.getAnalyser().startAnalysis();
+
+    auto* slot = processor.parameters.getParameter("abSlot");
+    auto* morph = processor.parameters.getParameter("morph");
+
+    AudioSampleBuffer block(numChannels, blockSize);
+    MidiBuffer midi;
+    const int numBlocks = jmax(1, signal.getNumSamples() / blockSize);
+    const int64 totalBlocks = jmax((int64) 64, (int64) (sampleRate / blockSize));
+
+    for (int64 i = 0; i < totalBlocks; i++)
+    {
+        // Every few blocks, move every parameter (band enables included) and the processing grid.
+        // The A/B slot and the morph are left to the schedule below, so a random switch cannot stall the sweep.
+        if (i % 4 == 0)
+        {
+            for (auto* parameter : processor.getParameters())
+                if (parameter != slot && parameter != morph)
+                    parameter->setValueNotifyingHost(random.nextFloat());
+
+            processor.setProcessingGridSize(random.nextBool() ? 0 : 1 << random.nextInt({ 4, 9 }));
+        }
+
+        // A/B switches, the morph, copies between the slots and preset crossfades, each on its own cadence
+        if (i % 8 == 2)
+            slot->setValueNotifyingHost(slot->getValue() < 0.5f ? 1.0f : 0.0f);
+        if (i % 8 == 6)
+            morph->setValueNotifyingHost(random.nextBool() ? 0.0f : random.nextFloat());
+        if (i % 16 == 10)
+            processor.setCurrentProgram(random.nextInt(processor.getNumPrograms()));
+        if (i % 16 == 14)
+            processor.copyToOtherSlot();
+
+        // What the message thread's timer does between blocks
+        processor.writeBackSlotSwitch();
+
+        const int offset = (int) (i % numBlocks) * blockSize;
+        for (int channel = 0; channel < numChannels; channel++)
+            block.copyFrom(channel, 0, signal, channel, offset, blockSize);
+
+        RealtimeAudit::begin();
+        processor.processBlock(block, midi);
+        RealtimeAudit::end();
+    }
+
+    processor.getAnalyser().stopAnalysis();
+    processor.releaseResources();
+
+    cout << "audit passed: " << sampleRate << " Hz, " << blockSize << " samples" << endl;
+}
+
+//==============================================================================
+// Bytes currently handed out by the allocator, or -1 where that cannot be read
+static int64 getAllocatedBytes()
+{
+   #if JUCE_LINUX && defined (__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return (int64) mallinfo2().uordblks;
+   #else
+    return -1;
+   #endif
+}
+
+// Heap cost of each additional prepared instance, once the shared resources exist.
+// With editors, each instance also keeps its editor open, so the shared artwork and fonts are counted as well.
+static bool measureMemory(int numInstances, bool withEditors, double sampleRate, int blockSize)
+{
+    vector<unique_ptr<MultiBandCompressorAudioProcessor>> instances;
+    vector<unique_ptr<AudioProcessorEditor>> editors;
+
+    auto addInstance = [&]
+    {
+        auto processor = make_unique<MultiBandCompressorAudioProcessor>();
+        processor->setPlayConfigDetails(2, 2, sampleRate, blockSize);
+        processor->prepareToPlay(sampleRate, blockSize);
+
+        if (withEditors)
+            editors.emplace_back(processor->createEditor());
+
+        instances.push_back(move(processor));
+    };
+
+    // The first instance builds the shared tables, so it is kept out of the average
+    instances.reserve((size_t) numInstances + 1);
+    editors.reserve((size_t) numInstances + 1);
+    addInstance();
+
+    const int64 before = getAllocatedBytes();
+    if (before < 0)
+    {
+        cerr << "Heap usage can only be read with glibc 2.33 or later" << endl;
+        return false;
+    }
+
+    for (int i = 0; i < numInstances; i++)
+        addInstance();
+
+    const int64 after = getAllocatedBytes();
+
+    DynamicObject::Ptr line = new DynamicObject();
+    line->setProperty("target", "memory");
+    line->setProperty("version", JucePlugin_VersionString);
+    line->setProperty("sampleRate", sampleRate);
+    line->setProperty("blockSize", blockSize);
+    line->setProperty("instances", numInstances);
+    line->setProperty("editors", withEditors);
+    line->setProperty("objectBytes", (int64) sizeof(MultiBandCompressorAudioProcessor));
+    line->setProperty("heapBytesPerInstance", (double) (after - before) / numInstances);
+
+    cout << JSON::toString(var(line.get()), true) << endl;
+
+    // Editors go before their processors
+    editors.clear();
+    return true;
+}
+
+//==============================================================================
+// Time to load a session: construct instances and restore their state, then open a few editors
+static void measureStartup(int numInstances)
+{
+    auto millisecondsSince = [] (int64 start) { return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0; };
+
+    // A saved state, as a host would hand to every instance of a session. It differs from a new instance's,
+    // with slot B holding another preset, so restoring it does the whole write rather than the early out.
+    MemoryBlock state;
+    {
+        MultiBandCompressorAudioProcessor source;
+        source.setCurrentProgram(2);
+        source.copyToOtherSlot();
+        source.setCurrentProgram(1);
+        source.getStateInformation(state);
+    }
+
+    vector<unique_ptr<MultiBandCompressorAudioProcessor>> instances;
+    instances.reserve((size_t) numInstances);
+
+    int64 start = Time::getHighResolutionTicks();
+    for (int i = 0; i < numInstances; i++)
+        instances.push_back(make_unique<MultiBandCompressorAudioProcessor>());
+    const double constructMs = millisecondsSince(start);
+
+    start = Time::getHighResolutionTicks();
+    for (auto& instance : instances)
+        instance->setStateInformation(state.getData(), (int) state.getSize());
+    const double restoreMs = millisecondsSince(start);
+
+    // Only a handful of editors are open at once in a real session
+    const int numEditors = jmin(numInstances, 20);
+    start = Time::getHighResolutionTicks();
+    for (int i = 0; i < numEditors; i++)
+        unique_ptr<AudioProcessorEditor> editor(instances[(size_t) i]->createEditor());
+    const double editorMs = millisecondsSince(start);
+
+    start = Time::getHighResolutionTicks();
+    instances.clear();
+    const double destroyMs = millisecondsSince(start);
+
+    DynamicObject::Ptr line = new DynamicObject();
+    line->setProperty("target", "startup");
+    line->setProperty("version", JucePlugin_VersionString);
+    line->setProperty("instances", numInstances);
+    line->setProperty("constructMsPerInstance", constructMs / numInstances);
+    line->setProperty("restoreMsPerInstance", restoreMs / numInstances);
+    line->setProperty("destroyMsPerInstance", destroyMs / numInstances);
+    line->setProperty("editors", numEditors);
+    line->setProperty("editorMsPerOpen", editorMs / numEditors);
+
+    cout << JSON::toString(var(line.get()), true) << endl;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    StringArray arguments;
+    for (int i = 1; i < argc; i++)
+        arguments.add(argv[i]);
+
+    const bool quick = arguments.contains("--quick");
+    const int secondsIndex = arguments.indexOf("--seconds");
+    const double audioSeconds = secondsIndex >= 0 ? arguments[secondsIndex + 1].getDoubleValue() : (quick ? 0.5 : 5.0);
+
+    const Array<int> blockSizes = quick ? Array<int> { 64, 512, 4096 }
+                                        : Array<int> { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    const Array<double> sampleRates = quick ? Array<double> { 48000.0 }
+                                            : Array<double> { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+
+    // Mono and stereo, the two layouts the processor runs
+    const Array<int> channelCounts { 1, 2 };
+
+    Random random(0x4d4243);
+
+    const int goldenIndex = arguments.indexOf("--golden");
+    if (goldenIndex >= 0)
+    {
+        const File directory = File::getCurrentWorkingDirectory().getChildFile(arguments[goldenIndex + 1]);
+
+        if (arguments.contains("--record"))
+            return RegressionTests::record(directory) ? 0 : 1;
+
+        // Bit-exact unless a tolerance is given
+        const int toleranceIndex = arguments.indexOf("--tolerance");
+        const float tolerance = toleranceIndex >= 0 ? arguments[toleranceIndex + 1].getFloatValue() : 0.0f;
+
+        const bool nullTestsPassed = RegressionTests::runNullTests();
+        const bool rateTestsPassed = RegressionTests::runRateTests();
+        const bool blockSizeTestsPassed = RegressionTests::runBlockSizeTests();
+        const bool slotTestsPassed = RegressionTests::runSlotTests();
+        const bool goldenPassed = RegressionTests::verify(directory, tolerance);
+        return nullTestsPassed && rateTestsPassed && blockSizeTestsPassed && slotTestsPassed && goldenPassed ? 0 : 1;
+    }
+
+    const int instancesIndex = arguments.indexOf("--instances");
+    if (arguments.contains("--memory"))
+    {
+        const int numInstances = instancesIndex >= 0 ? jmax(1, arguments[instancesIndex + 1].getIntValue()) : 100;
+        return measureMemory(numInstances, arguments.contains("--editors"), 48000.0, 512) ? 0 : 1;
+    }
+
+    if (arguments.contains("--startup"))
+    {
+        const int numInstances = instancesIndex >= 0 ? jmax(1, arguments[instancesIndex + 1].getIntValue()) : 500;
+        measureStartup(numInstances);
+        return 0;
+    }
+
+    if (arguments.contains("--audit"))
+    {
+        if (! RealtimeAudit::isAvailable())
+        {
+            cerr << "The real-time audit is only available on Linux" << endl;
+            return 1;
+        }
+
+        RealtimeAudit::initialise();
+
+        for (double sampleRate : sampleRates)
+        {
+            AudioSampleBuffer signal(2, (int) sampleRate);
+            fillSignal(signal, sampleRate, -12.0f, random);
+
+            for (int blockSize : blockSizes)
+                auditProcessor(sampleRate, blockSize, signal, random);
+        }
+
+        return 0;
+    }
+
+    for (double sampleRate : sampleRates)
+        for (int numChannels : channelCounts)
+            for (auto& regime : regimes)
+            {
+                AudioSampleBuffer signal(numChannels, (int) sampleRate);
+                fillSignal(signal, sampleRate, regime.inputLevelDb, random);
+
+                for (int blockSize : blockSizes)
+                {
+                    benchmarkCompressor(sampleRate, blockSize, numChannels, regime, signal, audioSeconds);
+                    benchmarkCrossover(sampleRate, blockSize, numChannels, regime, signal, audioSeconds);
+                    benchmarkProcessor("processor", MultiBandCompressorAudioProcessor::defaultProcessingGridSize, false,
+                                       sampleRate, blockSize, numChannels, regime, signal, audioSeconds);
+                    benchmarkProcessor("processorAutomated", MultiBandCompressorAudioProcessor::defaultProcessingGridSize, true,
+                                       sampleRate, blockSize, numChannels, regime, signal, audioSeconds);
+                    benchmarkProcessor("processorGridOff", 0, false, sampleRate, blockSize, numChannels, regime, signal, audioSeconds);
+                }
+            }
+
+    // Film stems: one surround instance against one stereo instance per channel pair
+    const AudioChannelSet surroundLayouts[] = { AudioChannelSet::create5point1(), AudioChannelSet::create7point1(),
+                                                AudioChannelSet::create7point1point4() };
+
+    for (double sampleRate : sampleRates)
+        for (auto& layout : surroundLayouts)
+            for (auto& regime : regimes)
+            {
+                AudioSampleBuffer signal(layout.size(), (int) sampleRate);
+                fillSignal(signal, sampleRate, regime.inputLevelDb, random);
+
+                for (int blockSize : blockSizes)
+                    benchmarkSurround(sampleRate, blockSize, layout, regime, signal, audioSeconds);
+            }
+
+    return 0;
+}
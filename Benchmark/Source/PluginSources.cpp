@@ -0,0 +1,20 @@
+/*
+  ==============================================================================
+
+    This file compiles the plugin sources into the benchmark, with the plugin
+    settings the Projucer generates for the plugin project.
+
+  ==============================================================================
+*/
+
+#include "../../JuceLibraryCode/JucePluginDefines.h"
+
+#include "../../Source/Compressor.cpp"
+#include "../../Source/Crossover.cpp"
+#include "../../Source/LevelMeter.cpp"
+#include "../../Source/MultiBandEngine.cpp"
+#include "../../Source/ResponseDisplay.cpp"
+#include "../../Source/SpectrumAnalyser.cpp"
+#include "../../Source/SpectrumDisplay.cpp"
+#include "../../Source/PluginProcessor.cpp"
+#include "../../Source/PluginEditor.cpp"
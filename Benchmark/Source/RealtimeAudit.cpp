@@ -0,0 +1,277 @@
+/*
+  ==============================================================================
+
+    This file contains the real-time safety audit. While a thread is inside
+    begin()/end(), any heap allocation, mutex, condition variable or rwlock
+    call, or sleeping system call on that thread prints a stack trace and
+    terminates the process.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RealtimeAudit.h"
+
+#if JUCE_LINUX && defined (__GLIBC__)
+ #include <dlfcn.h>
+ #include <errno.h>
+ #include <execinfo.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <string.h>
+ #include <time.h>
+ #include <unistd.h>
+
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void* __libc_memalign(size_t, size_t);
+extern "C" void  __libc_free(void*);
+
+namespace
+{
+    thread_local bool auditing = false;
+
+    using MutexFunction         = int (*) (pthread_mutex_t*);
+    using MutexTimedFunction    = int (*) (pthread_mutex_t*, const struct timespec*);
+    using CondWaitFunction      = int (*) (pthread_cond_t*, pthread_mutex_t*);
+    using CondTimedWaitFunction = int (*) (pthread_cond_t*, pthread_mutex_t*, const struct timespec*);
+    using RwLockFunction        = int (*) (pthread_rwlock_t*);
+    using RwLockTimedFunction   = int (*) (pthread_rwlock_t*, const struct timespec*);
+    using YieldFunction         = int (*) ();
+    using SleepFunction         = int (*) (const struct timespec*, struct timespec*);
+    using ClockSleepFunction    = int (*) (clockid_t, int, const struct timespec*, struct timespec*);
+    using MicroSleepFunction    = int (*) (useconds_t);
+
+    MutexFunction           realMutexLock       = nullptr;
+    MutexFunction           realMutexTryLock    = nullptr;
+    MutexTimedFunction      realMutexTimedLock  = nullptr;
+    CondWaitFunction        realCondWait        = nullptr;
+    CondTimedWaitFunction   realCondTimedWait   = nullptr;
+    RwLockFunction          realReadLock        = nullptr;
+    RwLockFunction          realWriteLock       = nullptr;
+    RwLockFunction          realTryReadLock     = nullptr;
+    RwLockFunction          realTryWriteLock    = nullptr;
+    RwLockTimedFunction     realTimedReadLock   = nullptr;
+    RwLockTimedFunction     realTimedWriteLock  = nullptr;
+    YieldFunction           realYield           = nullptr;
+    SleepFunction           realSleep           = nullptr;
+    ClockSleepFunction      realClockSleep      = nullptr;
+    MicroSleepFunction      realMicroSleep      = nullptr;
+
+    template <typename Function>
+    Function resolve(Function& function, const char* name)
+    {
+        if (function == nullptr)
+            function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+        return function;
+    }
+
+    // The condition variables exist in two versions, plain dlsym() may hand back the pre-2.3.2 one
+    template <typename Function>
+    Function resolveCondition(Function& function, const char* name)
+    {
+       #if defined (__x86_64__) || defined (__i386__)
+        if (function == nullptr)
+            function = reinterpret_cast<Function>(dlvsym(RTLD_NEXT, name, "GLIBC_2.3.2"));
+       #endif
+        return resolve(function, name);
+    }
+
+    // Uses only async-signal-safe calls, the heap may be the thing that was hit
+    [[noreturn]] void violation(const char* what)
+    {
+        auditing = false;
+
+        const char header[] = "Real-time violation on the processing thread: ";
+        ssize_t ignored = write(STDERR_FILENO, header, sizeof(header) - 1);
+        ignored = write(STDERR_FILENO, what, strlen(what));
+        ignored = write(STDERR_FILENO, "\n", 1);
+        (void) ignored;
+
+        void* frames[64];
+        backtrace_symbols_fd(frames, backtrace(frames, 64), STDERR_FILENO);
+        _exit(1);
+    }
+}
+
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        if (auditing) violation("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        if (auditing) violation("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        if (auditing) violation("realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        if (auditing) violation("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        if (auditing) violation("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        if (auditing) violation("posix_memalign");
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+
+    void free(void* pointer)
+    {
+        if (auditing && pointer != nullptr) violation("free");
+        __libc_free(pointer);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        if (auditing) violation("pthread_mutex_lock");
+        return resolve(realMutexLock, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_mutex_trylock(pthread_mutex_t* mutex)
+    {
+        if (auditing) violation("pthread_mutex_trylock");
+        return resolve(realMutexTryLock, "pthread_mutex_trylock")(mutex);
+    }
+
+    int pthread_mutex_timedlock(pthread_mutex_t* mutex, const struct timespec* timeout)
+    {
+        if (auditing) violation("pthread_mutex_timedlock");
+        return resolve(realMutexTimedLock, "pthread_mutex_timedlock")(mutex, timeout);
+    }
+
+    // Condition variables, which WaitableEvent and friends block in
+    int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        if (auditing) violation("pthread_cond_wait");
+        return resolveCondition(realCondWait, "pthread_cond_wait")(condition, mutex);
+    }
+
+    int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* timeout)
+    {
+        if (auditing) violation("pthread_cond_timedwait");
+        return resolveCondition(realCondTimedWait, "pthread_cond_timedwait")(condition, mutex, timeout);
+    }
+
+    // Read/write locks, ReadWriteLock and shared mutexes
+    int pthread_rwlock_rdlock(pthread_rwlock_t* lock)
+    {
+        if (auditing) violation("pthread_rwlock_rdlock");
+        return resolve(realReadLock, "pthread_rwlock_rdlock")(lock);
+    }
+
+    int pthread_rwlock_wrlock(pthread_rwlock_t* lock)
+    {
+        if (auditing) violation("pthread_rwlock_wrlock");
+        return resolve(realWriteLock, "pthread_rwlock_wrlock")(lock);
+    }
+
+    int pthread_rwlock_tryrdlock(pthread_rwlock_t* lock)
+    {
+        if (auditing) violation("pthread_rwlock_tryrdlock");
+        return resolve(realTryReadLock, "pthread_rwlock_tryrdlock")(lock);
+    }
+
+    int pthread_rwlock_trywrlock(pthread_rwlock_t* lock)
+    {
+        if (auditing) violation("pthread_rwlock_trywrlock");
+        return resolve(realTryWriteLock, "pthread_rwlock_trywrlock")(lock);
+    }
+
+    int pthread_rwlock_timedrdlock(pthread_rwlock_t* lock, const struct timespec* timeout)
+    {
+        if (auditing) violation("pthread_rwlock_timedrdlock");
+        return resolve(realTimedReadLock, "pthread_rwlock_timedrdlock")(lock, timeout);
+    }
+
+    int pthread_rwlock_timedwrlock(pthread_rwlock_t* lock, const struct timespec* timeout)
+    {
+        if (auditing) violation("pthread_rwlock_timedwrlock");
+        return resolve(realTimedWriteLock, "pthread_rwlock_timedwrlock")(lock, timeout);
+    }
+
+    int sched_yield()
+    {
+        if (auditing) violation("sched_yield");
+        return resolve(realYield, "sched_yield")();
+    }
+
+    int nanosleep(const struct timespec* duration, struct timespec* remaining)
+    {
+        if (auditing) violation("nanosleep");
+        return resolve(realSleep, "nanosleep")(duration, remaining);
+    }
+
+    int clock_nanosleep(clockid_t clock, int flags, const struct timespec* duration, struct timespec* remaining)
+    {
+        if (auditing) violation("clock_nanosleep");
+        return resolve(realClockSleep, "clock_nanosleep")(clock, flags, duration, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        if (auditing) violation("usleep");
+        return resolve(realMicroSleep, "usleep")(microseconds);
+    }
+}
+
+namespace RealtimeAudit
+{
+    bool isAvailable()  { return true; }
+
+    void initialise()
+    {
+        resolve(realMutexLock, "pthread_mutex_lock");
+        resolve(realMutexTryLock, "pthread_mutex_trylock");
+        resolve(realMutexTimedLock, "pthread_mutex_timedlock");
+        resolveCondition(realCondWait, "pthread_cond_wait");
+        resolveCondition(realCondTimedWait, "pthread_cond_timedwait");
+        resolve(realReadLock, "pthread_rwlock_rdlock");
+        resolve(realWriteLock, "pthread_rwlock_wrlock");
+        resolve(realTryReadLock, "pthread_rwlock_tryrdlock");
+        resolve(realTryWriteLock, "pthread_rwlock_trywrlock");
+        resolve(realTimedReadLock, "pthread_rwlock_timedrdlock");
+        resolve(realTimedWriteLock, "pthread_rwlock_timedwrlock");
+        resolve(realYield, "sched_yield");
+        resolve(realSleep, "nanosleep");
+        resolve(realClockSleep, "clock_nanosleep");
+        resolve(realMicroSleep, "usleep");
+
+        // The first backtrace() loads the unwinder, which allocates
+        void* frames[4];
+        backtrace(frames, 4);
+    }
+
+    void begin()        { auditing = true; }
+    void end()          { auditing = false; }
+}
+
+#else
+
+namespace RealtimeAudit
+{
+    bool isAvailable()  { return false; }
+    void initialise()   {}
+    void begin()        {}
+    void end()          {}
+}
+
+#endif
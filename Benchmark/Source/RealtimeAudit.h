@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+    This file contains the real-time safety audit. While a thread is inside
+    begin()/end(), any heap allocation, mutex, condition variable or rwlock
+    call, or sleeping system call on that thread prints a stack trace and
+    terminates the process.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+namespace RealtimeAudit
+{
+    // Interposition is only implemented on Linux with glibc
+    bool isAvailable();
+
+    // Resolves the wrapped functions, call once before the first begin()
+    void initialise();
+
+    void begin();
+    void end();
+}
@@ -0,0 +1,627 @@
+/*
+  ==============================================================================
+
+    This file contains the golden-output regression, null, sample rate and
+    block size tests. Generated signals are rendered through the processor at a fixed
+    set of presets and compared against reference renders stored as WAV files.
+
+  ==============================================================================
+*/
+
+#include "RegressionTests.h"
+#include "../../JuceLibraryCode/JucePluginDefines.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    // Render Settings, changing any of them invalidates the stored references
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numChannels = 2;
+    constexpr int numSamples = 48000;
+
+    //==============================================================================
+    // Test Signals
+    using SignalGenerator = void (*) (AudioSampleBuffer&);
+
+    void impulse(AudioSampleBuffer& buffer)
+    {
+        buffer.clear();
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+            buffer.setSample(channel, 0, 1.0f);
+    }
+
+    void sweep(AudioSampleBuffer& buffer)
+    {
+        // Logarithmic sine sweep from 20 Hz to 20 kHz at -6 dBFS
+        const double rate = log(20000.0 / 20.0) / buffer.getNumSamples();
+        double phase = 0;
+        for (int i = 0; i < buffer.getNumSamples(); i++)
+        {
+            const float sample = 0.5f * (float) sin(phase);
+            for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+                buffer.setSample(channel, i, sample);
+            phase += MathConstants<double>::twoPi * 20.0 * exp(rate * i) / sampleRate;
+        }
+    }
+
+    void noise(AudioSampleBuffer& buffer)
+    {
+        // White noise at -12 dBFS, different on each channel
+        Random random(0x6e6f6973);
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+            for (int i = 0; i < buffer.getNumSamples(); i++)
+                buffer.setSample(channel, i, 0.25f * (random.nextFloat() * 2.0f - 1.0f));
+    }
+
+    void bursts(AudioSampleBuffer& buffer)
+    {
+        // 1 kHz tone alternating between -40 and -6 dBFS every 100 ms, to exercise the ballistics
+        const int burstLength = (int) (0.1 * sampleRate);
+        for (int i = 0; i < buffer.getNumSamples(); i++)
+        {
+            const float level = (i / burstLength) % 2 == 0 ? 0.01f : 0.5f;
+            const float sample = level * (float) sin(MathConstants<double>::twoPi * 1000.0 * i / sampleRate);
+            for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+                buffer.setSample(channel, i, sample);
+        }
+    }
+
+    void silence(AudioSampleBuffer& buffer)
+    {
+        buffer.clear();
+    }
+
+    struct Signal
+    {
+        const char* name;
+        SignalGenerator generate;
+    };
+
+    const Signal signals[] =
+    {
+        { "impulse", impulse },
+        { "sweep",   sweep },
+        { "noise",   noise },
+        { "bursts",  bursts },
+        { "silence", silence },
+    };
+
+    //==============================================================================
+    // Parameter Presets, every parameter not listed keeps its default
+    struct Preset
+    {
+        const char* name;
+        vector<pair<const char*, float>> values;
+        int processingGridSize;
+    };
+
+    const vector<Preset>& getPresets()
+    {
+        static const vector<Preset> presets =
+        {
+            { "neutral", {}, 0 },
+            { "gentle",
+              { { "lowThresh", -20.0f }, { "midThresh", -20.0f }, { "highThresh", -20.0f },
+                { "lowRatio", 2.0f },    { "midRatio", 2.0f },    { "highRatio", 2.0f },
+                { "lowAttack", 20.0f },  { "midAttack", 20.0f },  { "highAttack", 20.0f },
+                { "lowRelease", 80.0f }, { "midRelease", 80.0f }, { "highRelease", 80.0f },
+                { "kneeWidth", 10.0f } }, 0 },
+            { "heavy",
+              { { "lowThresh", -50.0f }, { "midThresh", -50.0f }, { "highThresh", -50.0f },
+                { "lowRatio", 10.0f },   { "midRatio", 10.0f },   { "highRatio", 10.0f },
+                { "lowAttack", 5.0f },   { "midAttack", 5.0f },   { "highAttack", 5.0f },
+                { "lowRelease", 20.0f }, { "midRelease", 20.0f }, { "highRelease", 20.0f },
+                { "lowGain", 2.0f },     { "midGain", 2.0f },     { "highGain", 2.0f },
+                { "overallGain", 0.5f } }, 0 },
+            { "midBypassed",
+              { { "lowThresh", -50.0f }, { "midThresh", -50.0f }, { "highThresh", -50.0f },
+                { "lowRatio", 10.0f },   { "midRatio", 10.0f },   { "highRatio", 10.0f },
+                { "midEnabled", 0.0f } }, 0 },
+            { "cutoffsGridded",
+              { { "lowCutOff", 150.0f }, { "highCutOff", 4000.0f },
+                { "lowThresh", -30.0f }, { "midThresh", -30.0f }, { "highThresh", -30.0f },
+                { "lowRatio", 4.0f },    { "midRatio", 4.0f },    { "highRatio", 4.0f } }, 32 },
+        };
+
+        return presets;
+    }
+
+    //==============================================================================
+    void setParameter(MultiBandCompressorAudioProcessor& processor, const String& parameterID, float value)
+    {
+        if (auto* parameter = processor.parameters.getParameter(parameterID))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        else
+            jassertfalse;
+    }
+
+    // Parameter values set by the host ahead of the block that holds sample
+    struct Automation
+    {
+        int sample;
+        vector<pair<const char*, float>> values;
+    };
+
+    // Renders signal through a fresh processor set to preset, block by block
+    AudioSampleBuffer render(const Preset& preset, const AudioSampleBuffer& signal,
+                             int hostBlockSize = blockSize, const Automation* automation = nullptr)
+    {
+        MultiBandCompressorAudioProcessor processor;
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, hostBlockSize);
+
+        for (auto& value : preset.values)
+            setParameter(processor, value.first, value.second);
+        processor.setProcessingGridSize(preset.processingGridSize);
+
+        processor.prepareToPlay(sampleRate, hostBlockSize);
+
+        AudioSampleBuffer output(signal);
+        MidiBuffer midi;
+        for (int startSample = 0; startSample < output.getNumSamples(); startSample += hostBlockSize)
+        {
+            const int blockLength = jmin(hostBlockSize, output.getNumSamples() - startSample);
+            if (automation != nullptr && automation->sample >= startSample && automation->sample < startSample + blockLength)
+                for (auto& value : automation->values)
+                    setParameter(processor, value.first, value.second);
+
+            AudioSampleBuffer block(output.getArrayOfWritePointers(), numChannels, startSample, blockLength);
+            processor.processBlock(block, midi);
+        }
+
+        processor.releaseResources();
+        return output;
+    }
+
+    AudioSampleBuffer generate(const Signal& signal)
+    {
+        AudioSampleBuffer buffer(numChannels, numSamples);
+        signal.generate(buffer);
+        return buffer;
+    }
+
+    File getReferenceFile(const File& directory, const Signal& signal, const Preset& preset)
+    {
+        return directory.getChildFile(String(signal.name) + "_" + preset.name + ".wav");
+    }
+
+    //==============================================================================
+    // Bilinear Butterworth section in direct form, in double precision. It shares no code with the crossover,
+    // so the crossover can be checked against the analog Linkwitz-Riley bands it is meant to follow.
+    struct ReferenceBiquad
+    {
+        ReferenceBiquad(bool highPass, double rate, double cutOff)
+        {
+            const double k = tan(MathConstants<double>::pi * cutOff / rate);
+            const double norm = 1.0 / (1.0 + MathConstants<double>::sqrt2 * k + k * k);
+            b0 = (highPass ? 1.0 : k * k) * norm;
+            b1 = (highPass ? -2.0 : 2.0) * b0;
+            b2 = b0;
+            a1 = 2.0 * (k * k - 1.0) * norm;
+            a2 = (1.0 - MathConstants<double>::sqrt2 * k + k * k) * norm;
+        }
+
+        double process(double x)
+        {
+            const double y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+
+        double b0, b1, b2, a1, a2;
+        double z1 = 0, z2 = 0;
+    };
+
+    // The three Linkwitz-Riley bands of signal, two Butterworth sections per slope, summed at a third each
+    AudioSampleBuffer renderReferenceBandSum(const AudioSampleBuffer& signal, double rate, double lowCutOff, double highCutOff)
+    {
+        AudioSampleBuffer output(signal.getNumChannels(), signal.getNumSamples());
+
+        for (int channel = 0; channel < signal.getNumChannels(); channel++)
+        {
+            ReferenceBiquad low[] = { { false, rate, lowCutOff }, { false, rate, lowCutOff } };
+            ReferenceBiquad midHighPass[] = { { true, rate, lowCutOff }, { true, rate, lowCutOff } };
+            ReferenceBiquad midLowPass[] = { { false, rate, highCutOff }, { false, rate, highCutOff } };
+            ReferenceBiquad high[] = { { true, rate, highCutOff }, { true, rate, highCutOff } };
+
+            for (int i = 0; i < signal.getNumSamples(); i++)
+            {
+                const double x = signal.getSample(channel, i);
+                const double lowBand = low[1].process(low[0].process(x));
+                const double midBand = midLowPass[1].process(midLowPass[0].process(midHighPass[1].process(midHighPass[0].process(x))));
+                const double highBand = high[1].process(high[0].process(x));
+                output.setSample(channel, i, (float) ((lowBand + midBand + highBand) / 3.0));
+            }
+        }
+
+        return output;
+    }
+
+    //==============================================================================
+    struct Difference
+    {
+        float maxError;
+        double rmsErrorDb;
+    };
+
+    Difference compare(const AudioSampleBuffer& a, const AudioSampleBuffer& b)
+    {
+        jassert(a.getNumChannels() == b.getNumChannels() && a.getNumSamples() == b.getNumSamples());
+
+        float maxError = 0;
+        double sumOfSquares = 0;
+        for (int channel = 0; channel < a.getNumChannels(); channel++)
+            for (int i = 0; i < a.getNumSamples(); i++)
+            {
+                const float error = fabs(a.getSample(channel, i) - b.getSample(channel, i));
+                maxError = jmax(maxError, error);
+                sumOfSquares += (double) error * error;
+            }
+
+        const double rms = sqrt(sumOfSquares / jmax(1, a.getNumChannels() * a.getNumSamples()));
+        return { maxError, Decibels::gainToDecibels(rms, -300.0) };
+    }
+
+    void report(const String& test, const String& name, const Difference& difference, float tolerance, bool passed,
+                const String& error = {})
+    {
+        DynamicObject::Ptr line = new DynamicObject();
+        line->setProperty("test", test);
+        line->setProperty("version", JucePlugin_VersionString);
+        line->setProperty("name", name);
+        line->setProperty("maxError", difference.maxError);
+        line->setProperty("rmsErrorDb", difference.rmsErrorDb);
+        line->setProperty("tolerance", tolerance);
+        line->setProperty("passed", passed);
+        if (error.isNotEmpty())
+            line->setProperty("error", error);
+
+        cout << JSON::toString(var(line.get()), true) << endl;
+    }
+}
+
+//==============================================================================
+bool RegressionTests::record(const File& directory)
+{
+    if (! directory.createDirectory())
+    {
+        cerr << "Cannot create " << directory.getFullPathName() << endl;
+        return false;
+    }
+
+    WavAudioFormat format;
+    for (auto& signal : signals)
+    {
+        const AudioSampleBuffer input = generate(signal);
+
+        for (auto& preset : getPresets())
+        {
+            const File file = getReferenceFile(directory, signal, preset);
+            file.deleteFile();
+
+            // 32-bit float, so the references hold exactly what the processor produced
+            unique_ptr<AudioFormatWriter> writer(format.createWriterFor(file.createOutputStream().release(),
+                                                                        sampleRate, numChannels, 32, {}, 0));
+            const AudioSampleBuffer output = render(preset, input);
+
+            if (writer == nullptr || ! writer->writeFromAudioSampleBuffer(output, 0, output.getNumSamples()))
+            {
+                cerr << "Cannot write " << file.getFullPathName() << endl;
+                return false;
+            }
+
+            cout << "recorded " << file.getFileName() << endl;
+        }
+    }
+
+    // How the references were made, since their bits depend on the build that rendered them
+    DynamicObject::Ptr recording = new DynamicObject();
+    recording->setProperty("version", JucePlugin_VersionString);
+   #if defined (_MSC_FULL_VER)
+    recording->setProperty("compiler", "MSVC " + String(_MSC_FULL_VER));
+   #else
+    recording->setProperty("compiler", __VERSION__);
+   #endif
+   #if JUCE_USE_SIMD
+    recording->setProperty("simdFloats", (int) dsp::SIMDRegister<float>::SIMDNumElements);
+   #else
+    recording->setProperty("simdFloats", 1);
+   #endif
+    recording->setProperty("platform", SystemStats::getOperatingSystemName());
+    recording->setProperty("cpu", SystemStats::getCpuModel());
+    recording->setProperty("recorded", Time::getCurrentTime().toISO8601(true));
+
+    const File recordingFile = directory.getChildFile("recording.json");
+    if (! recordingFile.replaceWithText(JSON::toString(var(recording.get()))))
+    {
+        cerr << "Cannot write " << recordingFile.getFullPathName() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool RegressionTests::verify(const File& directory, float tolerance)
+{
+    WavAudioFormat format;
+    bool passed = true;
+
+    for (auto& signal : signals)
+    {
+        const AudioSampleBuffer input = generate(signal);
+
+        for (auto& preset : getPresets())
+        {
+            const File file = getReferenceFile(directory, signal, preset);
+            unique_ptr<AudioFormatReader> reader(format.createReaderFor(file.createInputStream().release(), true));
+
+            // A missing reference is a failure of its own case, never a skipped one
+            if (reader == nullptr || reader->numChannels != numChannels || reader->lengthInSamples != numSamples)
+            {
+                const String error = reader == nullptr ? "missing reference " : "mismatched reference ";
+                report("golden", file.getFileNameWithoutExtension(), { numeric_limits<float>::infinity(), 0.0 }, tolerance, false,
+                       error + file.getFullPathName());
+                passed = false;
+                continue;
+            }
+
+            AudioSampleBuffer reference(numChannels, numSamples);
+            reader->read(&reference, 0, numSamples, 0, true, true);
+
+            const Difference difference = compare(render(preset, input), reference);
+            const bool casePassed = difference.maxError <= tolerance;
+            report("golden", file.getFileNameWithoutExtension(), difference, tolerance, casePassed);
+            passed = passed && casePassed;
+        }
+    }
+
+    return passed;
+}
+
+bool RegressionTests::runNullTests()
+{
+    bool passed = true;
+
+    for (auto& signal : signals)
+    {
+        const AudioSampleBuffer input = generate(signal);
+
+        // A compressor at 0 dB threshold and unity make up gain must leave the signal bit for bit
+        {
+            Compressor compressor;
+            compressor.prepareToPlay(sampleRate, blockSize, numChannels);
+            compressor.setParameters(1.0f, 0.0f, 5.0f, 5.0f, 1.0f, 5.0f);
+
+            AudioSampleBuffer output(input);
+            for (int startSample = 0; startSample < numSamples; startSample += blockSize)
+            {
+                AudioSampleBuffer block(output.getArrayOfWritePointers(), numChannels, startSample,
+                                        jmin(blockSize, numSamples - startSample));
+                compressor.processBlock(block);
+            }
+
+            const Difference difference = compare(output, input);
+            const bool casePassed = difference.maxError == 0.0f;
+            report("nullCompressor", signal.name, difference, 0.0f, casePassed);
+            passed = passed && casePassed;
+        }
+
+        // At neutral settings the compressors pass their bands unchanged, but the processor still does not give
+        // back its input: it sums the three crossover bands at a third each, and three parallel Linkwitz-Riley
+        // bands do not sum to an allpass. It must match those bands built independently instead.
+        // Against the double precision reference the float crossover was measured within 4e-7.
+        {
+            const AudioSampleBuffer expected = renderReferenceBandSum(input, sampleRate, 450.0, 2500.0);
+
+            const float tolerance = 1.0e-6f;
+            const Difference difference = compare(render(getPresets().front(), input), expected);
+            const bool casePassed = difference.maxError <= tolerance;
+            report("nullProcessor", signal.name, difference, tolerance, casePassed);
+            passed = passed && casePassed;
+        }
+    }
+
+    return passed;
+}
+
+bool RegressionTests::runRateTests()
+{
+    const double testRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0, 352800.0, 384000.0 };
+    bool passed = true;
+
+    // Crossover at its outermost cutoffs: each band's sine gain against the analog Linkwitz-Riley response.
+    // The test frequencies stay low enough for the bilinear warping at 44.1 kHz to be within the tolerance.
+    {
+        const float lowCutOff = 150.0f, highCutOff = 4000.0f;
+        const double frequencies[] = { 50.0, 150.0, 500.0, 1000.0, 2000.0, 4000.0 };
+        const float tolerance = 0.01f;
+
+        auto lowPass = [] (double f, double fc) { return 1.0 / (1.0 + pow(f / fc, 4.0)); };
+        auto highPass = [] (double f, double fc) { return 1.0 - 1.0 / (1.0 + pow(f / fc, 4.0)); };
+
+        for (double rate : testRates)
+        {
+            float maxError = 0;
+
+            for (double frequency : frequencies)
+            {
+                // A quarter second to settle, then half a second (a whole number of cycles) measured
+                const int settleSamples = roundToInt(0.25 * rate);
+                const int measureSamples = roundToInt(0.5 * rate);
+                const int length = settleSamples + measureSamples;
+
+                Crossover crossover;
+                crossover.prepare(rate, 1);
+                crossover.setCutoffs(lowCutOff, highCutOff);
+
+                AudioSampleBuffer low(1, length), mid(1, length), high(1, length);
+                for (int i = 0; i < length; i++)
+                    low.setSample(0, i, (float) sin(MathConstants<double>::twoPi * frequency * i / rate));
+                mid.copyFrom(0, 0, low, 0, 0, length);
+                high.copyFrom(0, 0, low, 0, 0, length);
+
+                for (int startSample = 0; startSample < length; startSample += blockSize)
+                {
+                    const int blockLength = jmin(blockSize, length - startSample);
+                    AudioSampleBuffer lowBlock(low.getArrayOfWritePointers(), 1, startSample, blockLength);
+                    AudioSampleBuffer midBlock(mid.getArrayOfWritePointers(), 1, startSample, blockLength);
+                    AudioSampleBuffer highBlock(high.getArrayOfWritePointers(), 1, startSample, blockLength);
+                    crossover.process(lowBlock, midBlock, highBlock, 1, blockLength);
+                }
+
+                const double expected[] = { lowPass(frequency, lowCutOff),
+                                            highPass(frequency, lowCutOff) * lowPass(frequency, highCutOff),
+                                            highPass(frequency, highCutOff) };
+                const AudioSampleBuffer* bands[] = { &low, &mid, &high };
+
+                for (int band = 0; band < 3; band++)
+                {
+                    const double gain = bands[band]->getRMSLevel(0, settleSamples, measureSamples) * MathConstants<double>::sqrt2;
+                    maxError = jmax(maxError, (float) fabs(gain - expected[band]));
+                }
+            }
+
+            const bool casePassed = maxError <= tolerance;
+            report("rateCrossover", String(rate / 1000.0, 1) + " kHz", { maxError, Decibels::gainToDecibels((double) maxError, -300.0) }, tolerance, casePassed);
+            passed = passed && casePassed;
+        }
+    }
+
+    // Compressor ballistics: the gain at fixed times after a level step up and back down must not depend on the rate.
+    // The times are whole numbers of samples at every test rate, where the exponential ballistics are exact.
+    {
+        const double stepTime = 0.1, releaseTime = 0.3, endTime = 0.5;
+        const double probeTimes[] = { 0.01, 0.02, 0.05, 0.1 };
+        const float tolerance = 0.05f;    // dB
+
+        auto measureGains = [&] (double rate)
+        {
+            Compressor compressor;
+            compressor.prepareToPlay(rate, blockSize, 1);
+            compressor.setParameters(4.0f, -30.0f, 10.0f, 50.0f, 1.0f, 5.0f);
+
+            const int length = roundToInt(endTime * rate);
+            AudioSampleBuffer signal(1, length);
+            for (int i = 0; i < length; i++)
+                signal.setSample(0, i, i >= roundToInt(stepTime * rate) && i < roundToInt(releaseTime * rate) ? 0.5f : 0.01f);
+
+            AudioSampleBuffer output(signal);
+            for (int startSample = 0; startSample < length; startSample += blockSize)
+            {
+                AudioSampleBuffer block(output.getArrayOfWritePointers(), 1, startSample, jmin(blockSize, length - startSample));
+                compressor.processBlock(block);
+            }
+
+            vector<float> gains;
+            for (double start : { stepTime, releaseTime })
+                for (double probe : probeTimes)
+                {
+                    const int i = roundToInt((start + probe) * rate) - 1;
+                    gains.push_back(Decibels::gainToDecibels(output.getSample(0, i) / signal.getSample(0, i)));
+                }
+
+            return gains;
+        };
+
+        const vector<float> reference = measureGains(48000.0);
+
+        for (double rate : testRates)
+        {
+            const vector<float> gains = measureGains(rate);
+
+            float maxError = 0;
+            for (size_t i = 0; i < gains.size(); i++)
+                maxError = jmax(maxError, fabs(gains[i] - reference[i]));
+
+            const bool casePassed = maxError <= tolerance;
+            report("rateBallistics", String(rate / 1000.0, 1) + " kHz", { maxError, Decibels::gainToDecibels((double) maxError, -300.0) }, tolerance, casePassed);
+            passed = passed && casePassed;
+        }
+    }
+
+    return passed;
+}
+
+bool RegressionTests::runBlockSizeTests()
+{
+    // Block sizes that either fit the grid or divide the automation point, so the change lands on the same grid line
+    const int hostBlockSizes[] = { 1, 17, 64, 4096 };
+    const Automation automation { 6 * 4096,
+                                  { { "lowThresh", -40.0f }, { "midRatio", 8.0f }, { "highGain", 1.5f },
+                                    { "lowCutOff", 200.0f }, { "highCutOff", 3000.0f }, { "overallGain", 0.7f } } };
+    const float tolerance = 1.0e-6f;
+    bool passed = true;
+
+    for (auto& signal : signals)
+    {
+        const AudioSampleBuffer input = generate(signal);
+
+        for (auto preset : getPresets())
+        {
+            preset.processingGridSize = MultiBandCompressorAudioProcessor::defaultProcessingGridSize;
+            const AudioSampleBuffer reference = render(preset, input, blockSize, &automation);
+
+            for (int hostBlockSize : hostBlockSizes)
+            {
+                const Difference difference = compare(render(preset, input, hostBlockSize, &automation), reference);
+                const bool casePassed = difference.maxError <= tolerance;
+                report("blockSize", String(signal.name) + "_" + preset.name + "_" + String(hostBlockSize), difference, tolerance, casePassed);
+                passed = passed && casePassed;
+            }
+        }
+    }
+
+    return passed;
+}
+
+bool RegressionTests::runSlotTests()
+{
+    // Slot B gets the heavy preset, slot A the gentle one
+    MultiBandCompressorAudioProcessor processor;
+    processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    const auto& presets = getPresets();
+    for (auto& value : presets[2].values)
+        setParameter(processor, value.first, value.second);
+    processor.copyToOtherSlot();
+
+    for (auto& value : presets[1].values)
+        setParameter(processor, value.first, value.second);
+
+    NamedValueSet expected;
+    ParameterSnapshot slotA = processor.getParameterSnapshot();
+    visitParameters(slotA, [&expected] (const String& parameterID, float value) { expected.set(parameterID, value); });
+
+    AudioSampleBuffer buffer = generate(signals[2]);
+    MidiBuffer midi;
+    auto process = [&] (int startSample)
+    {
+        const int endSample = startSample + numSamples / 4;
+        for (int i = startSample; i < endSample; i += blockSize)
+        {
+            AudioSampleBuffer block(buffer.getArrayOfWritePointers(), numChannels, i, jmin(blockSize, endSample - i));
+            processor.processBlock(block, midi);
+        }
+    };
+
+    // Morphed halfway, switching from A to B and back must leave slot A as it was
+    setParameter(processor, "morph", 0.5f);
+    process(0);
+    processor.selectSlot(1);
+    process(numSamples / 4);
+    processor.selectSlot(0);
+    process(numSamples / 2);
+
+    float maxError = 0;
+    ParameterSnapshot saved = processor.getSlotValues(0);
+    visitParameters(saved, [&] (const String& parameterID, float value)
+    {
+        maxError = jmax(maxError, fabs(value - (float) expected[parameterID]));
+    });
+
+    const bool passed = maxError == 0.0f && processor.getActiveSlot() == 0;
+    report("slotMorph", "slotA", { maxError, Decibels::gainToDecibels((double) maxError, -300.0) }, 0.0f, passed);
+    return passed;
+}
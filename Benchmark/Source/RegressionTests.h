@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    This file contains the golden-output regression, null, sample rate and
+    block size tests. Generated signals are rendered through the processor at a fixed
+    set of presets and compared against reference renders stored as WAV files.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace std;
+using namespace juce;
+
+namespace RegressionTests
+{
+    // Writes the reference renders into directory, replacing any existing ones
+    bool record(const File& directory);
+
+    // Compares against the reference renders, fails on any sample further than tolerance away
+    bool verify(const File& directory, float tolerance);
+
+    // Neutral settings must give back the input (compressor) or the Linkwitz-Riley band sum, built independently (processor)
+    bool runNullTests();
+
+    // The crossover response and the compressor ballistics must be the same from 44.1 to 384 kHz
+    bool runRateTests();
+
+    // On the processing grid, the output must not depend on how the host splits its blocks
+    bool runBlockSizeTests();
+
+    // An A/B switch while morphing must keep each slot's own values, never the blend
+    bool runSlotTests();
+}
@@ -12,97 +12,315 @@
 using namespace std;
 using namespace juce;
 
+void Compressor::publishBypass(const AudioSampleBuffer& buffer)
+{
+    if (meter == nullptr)
+        return;
+
+    const float peak = buffer.getMagnitude(0, buffer.getNumSamples());
+    meter->publish(peak, peak, 0.0f);
+}
+
 void Compressor::processBlock(AudioSampleBuffer &buffer)
 {
     int bufferSize = buffer.getNumSamples();
-    int numChannels = buffer.getNumChannels();        // number of channels
-    int M = round(numChannels / 2);              // number of stereo channels
-    
-    // create blank input buffer to add to
-    AudioSampleBuffer inputBuffer(M, bufferSize);
-    inputBuffer.clear();
+    const int numChannels = buffer.getNumChannels();        // number of channels
+    int M = groups.numGroups;                               // number of detectors
     
-    for (int m = 0 ; m < M ; ++m)   //For each channel pair of channels
+    // the detector and ramp buffers are allocated in prepareToPlay, the detector buffer's last channel is scratch
+    const int rectifiedChannel = inputBuffer.getNumChannels() - 1;
+    jassert(M <= rectifiedChannel && bufferSize <= inputBuffer.getNumSamples());
+    M = jmin(M, rectifiedChannel);
+    bufferSize = jmin(bufferSize, inputBuffer.getNumSamples());
+
+    // Metering: input peak before compression, largest gain reduction within the block
+    const float inputPeak = meter != nullptr ? buffer.getMagnitude(0, bufferSize) : 0.0f;
+    float maxGainReduction = 0;
+
+    // Compress unless the threshold rests at 0 dB, decided once so every channel group takes the same branch
+    const bool compressing = smoothedThreshold.getCurrentValue() < 0 || smoothedThreshold.isSmoothing();
+
+    // While a parameter moves, the ramps are stepped once per block and every channel group reads them.
+    // Static parameters skip this, the loops below read them as constants.
+    const bool smoothing = smoothedThreshold.isSmoothing() || smoothedRatio.isSmoothing()
+                        || smoothedMakeUpGain.isSmoothing() || smoothedKneeWidth.isSmoothing();
+    if (smoothing)
+        fillRamps(bufferSize);
+
+    // if threshold = 0, still apply make up gain: one gain for the block, or the ramp's gains computed once for every group
+    float* makeUpGains = rampBuffer.getWritePointer(makeUpGainRamp);
+    const float makeUpGain = Decibels::decibelsToGain(cMakeUpGain, -1000.0f);
+    if (! compressing && smoothing)
+        for (int i = 0 ; i < bufferSize ; ++i)
+            makeUpGains[i] = Decibels::decibelsToGain(makeUpGains[i], -1000.0f);
+
+    for (int m = 0 ; m < M ; ++m)   //For each channel group
     {
-        if (compressorState)        // check if compressor is active
+        // The channels of this group that the buffer has
+        float* groupChannels[ChannelGroups::maxChannels];
+        int numGroupChannels = 0;
+        for (int c = 0; c < groups.getNumChannels(m); ++c)
+            if (groups.getChannel(m, c) < numChannels)
+                groupChannels[numGroupChannels++] = buffer.getWritePointer(groups.getChannel(m, c));
+
+        if (numGroupChannels == 0)
+            continue;
+
+        if (compressing) // check if compressor threshold is non-zero
         {
-            if ( (cThreshold < 0) ) // check if compressor threshold is non-zero
-            {
-                // Mix down left-right to analyse the input
-                inputBuffer.addFrom(m,0,buffer,m * 2,0,bufferSize,0.5);
-                inputBuffer.addFrom(m,0,buffer,m * 2 + 1,0,bufferSize,0.5);
-                
-                // compression : calculates the control voltage
-                float alphaAttack = exp(-1/(0.001 * cSampleRate * cAttack));
-                float alphaRelease= exp(-1/(0.001 * cSampleRate * cRelease));
-
-                for (int i = 0 ; i < bufferSize ; ++i)
-                {
-                    //Level detection- estimate level using peak detector
-                    if (fabs(buffer.getWritePointer(m)[i]) < 0.000001)
-                    {
-                        inputGain =-120;
-                    }
-                    else
-                    {
-                        inputGain = 20 * log10(fabs(buffer.getWritePointer(m)[i]));
-                    }
-                    
-                    // Gain computer - apply input/output curve with kneewidth
-                    // Incorporating the SOFT KNEE
-                    if (2 * (inputGain-cThreshold) >= cKneeWidth)
-                    {
-                        // above knee
-                        outputGain = cThreshold+ (inputGain - cThreshold) / cRatio;
-                    }
-                    else if (2 * fabs(inputGain - cThreshold) <= cKneeWidth)
-                    {
-                        // in knee
-                        outputGain = inputGain + (1/cRatio - 1) * pow(inputGain - cThreshold + cKneeWidth/2, 2)/(2 * cKneeWidth);
-                    }
-                    else {
-                        // below knee
-                        outputGain = inputGain;
-                    }
-                    
-                    inputLevel = inputGain - outputGain;
-                    
-                    //Ballistics - smoothing of the gain
-                    if (inputLevel > previousOutputLevel)
-                        outputLevel = alphaAttack * previousOutputLevel + (1 - alphaAttack) * inputLevel;
-                    else
-                        outputLevel = alphaRelease * previousOutputLevel + (1 - alphaRelease) * inputLevel;
-                    
-                    //find control voltage
-                    controlVoltage = pow(10,(cMakeUpGain - outputLevel) / 20);
-                    previousOutputLevel = outputLevel;
-                    
-                    // apply control voltage to both channels
-                    buffer.getWritePointer(2 * m + 0)[i] *= controlVoltage;
-                    buffer.getWritePointer(2 * m + 1)[i] *= controlVoltage;
-                }
-            }
-            else
+            // Linked detection: the peak of the group's channels, rectified and combined a vector at a time
+            float* detector = inputBuffer.getWritePointer(m);
+            float* rectified = inputBuffer.getWritePointer(rectifiedChannel);
+            FloatVectorOperations::abs(detector, groupChannels[0], bufferSize);
+            for (int c = 1; c < numGroupChannels; ++c)
             {
-                // if threshold = 0, still apply make up gain.
-                buffer.applyGain(pow(10,(cMakeUpGain) / 20));
+                FloatVectorOperations::abs(rectified, groupChannels[c], bufferSize);
+                FloatVectorOperations::max(detector, detector, rectified, bufferSize);
             }
+
+            // compression : turns the detector levels into the control voltage
+            previousOutputLevel[m] = smoothing ? compressGroup<true>(detector, bufferSize, previousOutputLevel[m], maxGainReduction)
+                                               : compressGroup<false>(detector, bufferSize, previousOutputLevel[m], maxGainReduction);
+
+            // apply control voltage to every channel of the group
+            for (int c = 0; c < numGroupChannels; ++c)
+                FloatVectorOperations::multiply(groupChannels[c], detector, bufferSize);
+        }
+        else if (smoothing)
+        {
+            for (int c = 0; c < numGroupChannels; ++c)
+                FloatVectorOperations::multiply(groupChannels[c], makeUpGains, bufferSize);
+        }
+        else if (makeUpGain != 1.0f)
+        {
+            for (int c = 0; c < numGroupChannels; ++c)
+                FloatVectorOperations::multiply(groupChannels[c], makeUpGain, bufferSize);
         }
     }
+
+    if (meter != nullptr)
+        meter->publish(inputPeak, buffer.getMagnitude(0, bufferSize), maxGainReduction);
+}
+
+template <bool rampParameters>
+float Compressor::compressGroup(float* detector, int numSamples, float previousLevel, float& maxGainReduction)
+{
+    const float* thresholds = rampBuffer.getReadPointer(thresholdRamp);
+    const float* ratios = rampBuffer.getReadPointer(ratioRamp);
+    const float* kneeWidths = rampBuffer.getReadPointer(kneeWidthRamp);
+    const float* makeUpGains = rampBuffer.getReadPointer(makeUpGainRamp);
+
+    for (int i = 0 ; i < numSamples ; ++i)
+    {
+        // The block's ramps while a parameter moves, the static values otherwise
+        const float threshold = rampParameters ? thresholds[i] : cThreshold;
+        const float ratio = rampParameters ? ratios[i] : cRatio;
+        const float kneeWidth = rampParameters ? kneeWidths[i] : cKneeWidth;
+        const float makeUpGain = rampParameters ? makeUpGains[i] : cMakeUpGain;
+
+        //Level detection- estimate level using peak detector
+        if (fastMath)
+        {
+            inputGain = decibelTables->gainToDecibels(detector[i], -120, 0.000001f);
+        }
+        else if (detector[i] < 0.000001)
+        {
+            inputGain =-120;
+        }
+        else
+        {
+            inputGain = 20 * log10(detector[i]);
+        }
+        
+        // Gain computer - apply input/output curve with kneewidth
+        outputGain = computeOutputGain(inputGain, threshold, ratio, kneeWidth);
+        
+        inputLevel = inputGain - outputGain;
+        
+        //Ballistics - smoothing of the gain
+        if (inputLevel > previousLevel)
+            outputLevel = alphaAttack * previousLevel + (1 - alphaAttack) * inputLevel;
+        else
+            outputLevel = alphaRelease * previousLevel + (1 - alphaRelease) * inputLevel;
+        
+        //find control voltage
+        controlVoltage = fastMath ? decibelTables->decibelsToGain(makeUpGain - outputLevel)
+                                  : pow(10,(makeUpGain - outputLevel) / 20);
+        previousLevel = outputLevel;
+        maxGainReduction = jmax(maxGainReduction, outputLevel);
+        
+        // the detector buffer now holds the gain
+        detector[i] = controlVoltage;
+    }
+
+    return previousLevel;
+}
+
+void Compressor::fillRamps(int numSamples)
+{
+    // A parameter that is not moving fills its ramp with its value
+    auto fill = [numSamples] (SmoothedValue<float>& value, float* ramp)
+    {
+        if (! value.isSmoothing())
+        {
+            FloatVectorOperations::fill(ramp, value.getTargetValue(), numSamples);
+            return;
+        }
+
+        for (int i = 0 ; i < numSamples ; ++i)
+            ramp[i] = value.getNextValue();
+    };
+
+    fill(smoothedThreshold, rampBuffer.getWritePointer(thresholdRamp));
+    fill(smoothedRatio, rampBuffer.getWritePointer(ratioRamp));
+    fill(smoothedKneeWidth, rampBuffer.getWritePointer(kneeWidthRamp));
+    fill(smoothedMakeUpGain, rampBuffer.getWritePointer(makeUpGainRamp));
+
+    // The static values pick up where the ramps ended
+    cThreshold = smoothedThreshold.getCurrentValue();
+    cRatio = smoothedRatio.getCurrentValue();
+    cKneeWidth = smoothedKneeWidth.getCurrentValue();
+    cMakeUpGain = smoothedMakeUpGain.getCurrentValue();
 }
 
 void Compressor::setParameters(float ratio, float threshold, float attack, float release, float makeUpGain, float kneeWidth)
 {
-    cRatio = ratio;
-    cThreshold = threshold;
+    // The ballistics are recomputed only when a time moves or after a prepare
+    const bool timesChanged = ! parametersInitialised || attack != cAttack || release != cRelease;
     cAttack = attack;
     cRelease = release;
-    cMakeUpGain = Decibels::gainToDecibels(makeUpGain);
-    cKneeWidth = kneeWidth;
+
+    if (timesChanged)
+        updateBallistics();
+
+    // Jump straight to the first values after a prepare, ramp to any later ones
+    if (! parametersInitialised)
+    {
+        smoothedThreshold.setCurrentAndTargetValue(threshold);
+        smoothedRatio.setCurrentAndTargetValue(ratio);
+        smoothedMakeUpGain.setCurrentAndTargetValue(Decibels::gainToDecibels(makeUpGain));
+        smoothedKneeWidth.setCurrentAndTargetValue(kneeWidth);
+        parametersInitialised = true;
+    }
+    else
+    {
+        smoothedThreshold.setTargetValue(threshold);
+        smoothedRatio.setTargetValue(ratio);
+        smoothedMakeUpGain.setTargetValue(Decibels::gainToDecibels(makeUpGain));
+        smoothedKneeWidth.setTargetValue(kneeWidth);
+    }
+
+    // Static parameters are read straight from the ramps' current values
+    cThreshold = smoothedThreshold.getCurrentValue();
+    cRatio = smoothedRatio.getCurrentValue();
+    cMakeUpGain = smoothedMakeUpGain.getCurrentValue();
+    cKneeWidth = smoothedKneeWidth.getCurrentValue();
+}
+
+void Compressor::updateBallistics()
+{
+    // Smoothing coefficients for time constants in ms, the same curve at any sample rate
+    alphaAttack = exp(-1/(0.001 * cSampleRate * cAttack));
+    alphaRelease= exp(-1/(0.001 * cSampleRate * cRelease));
 }
 
 void Compressor::prepareToPlay(double samplerate, int samplesPerBlock, int numInputChannels)
 {
     cSampleRate = samplerate;
-    previousOutputLevel = 0;
+
+    // All channels share one detector until told otherwise.
+    // The detector buffer has room for one detector per channel, the most any grouping needs, and one scratch channel.
+    groups = ChannelGroups::linkAll(numInputChannels);
+    inputBuffer.setSize(jlimit(1, ChannelGroups::maxChannels, numInputChannels) + 1, jmax(1, samplesPerBlock));
+    rampBuffer.setSize(numRamps, jmax(1, samplesPerBlock));
+
+    // Reset the parameter ramps
+    smoothedThreshold.reset(samplerate, smoothingTime);
+    smoothedRatio.reset(samplerate, smoothingTime);
+    smoothedMakeUpGain.reset(samplerate, smoothingTime);
+    smoothedKneeWidth.reset(samplerate, smoothingTime);
+    reset();
+}
+
+void Compressor::reset()
+{
+    // Every detector back to silence, the next setParameters() jumps to its values instead of ramping
+    fill(begin(previousOutputLevel), end(previousOutputLevel), 0.0f);
+    parametersInitialised = false;
+}
+
+//==============================================================================
+ChannelGroups::Role ChannelGroups::getRole(AudioChannelSet::ChannelType type)
+{
+    switch (type)
+    {
+        case AudioChannelSet::LFE:
+        case AudioChannelSet::LFE2:
+            return lfe;
+
+        case AudioChannelSet::leftSurround:
+        case AudioChannelSet::rightSurround:
+        case AudioChannelSet::centreSurround:
+        case AudioChannelSet::leftSurroundSide:
+        case AudioChannelSet::rightSurroundSide:
+        case AudioChannelSet::leftSurroundRear:
+        case AudioChannelSet::rightSurroundRear:
+            return surround;
+
+        case AudioChannelSet::topMiddle:
+        case AudioChannelSet::topFrontLeft:
+        case AudioChannelSet::topFrontCentre:
+        case AudioChannelSet::topFrontRight:
+        case AudioChannelSet::topRearLeft:
+        case AudioChannelSet::topRearCentre:
+        case AudioChannelSet::topRearRight:
+            return height;
+
+        default:
+            return front;
+    }
+}
+
+ChannelGroups ChannelGroups::make(const Role* roles, int numChannels, const bool* linked)
+{
+    ChannelGroups result;
+    numChannels = jmin(numChannels, maxChannels);
+    int numAssigned = 0;
+
+    auto closeGroup = [&]
+    {
+        if (numAssigned > result.groupStart[result.numGroups])
+            result.groupStart[++result.numGroups] = numAssigned;
+    };
+
+    for (int role = 0; role < numLinkableRoles; role++)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            if (roles[channel] != role)
+                continue;
+
+            result.channels[numAssigned++] = channel;
+            if (! linked[role])
+                closeGroup();
+        }
+
+        closeGroup();
+    }
+
+    return result;
+}
+
+ChannelGroups ChannelGroups::linkAll(int numChannels)
+{
+    const Role roles[maxChannels] = {};
+    const bool linked[numLinkableRoles] = { true, true, true };
+    return make(roles, numChannels, linked);
+}
+
+bool ChannelGroups::operator== (const ChannelGroups& other) const
+{
+    return numGroups == other.numGroups
+        && equal(groupStart, groupStart + numGroups + 1, other.groupStart)
+        && equal(channels, channels + groupStart[numGroups], other.channels);
 }
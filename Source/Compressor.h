@@ -9,10 +9,65 @@
 #ifndef Compressor_h
 #define Compressor_h
 #include <JuceHeader.h>
+#include "DecibelTables.h"
 
 using namespace std;
 using namespace juce;
 
+// Peak-hold levels written by the audio thread and collected by the editor, without locks
+class CompressorMeter
+{
+public:
+    // Audio thread: raise each register to the block's value
+    void publish(float inputPeak, float outputPeak, float gainReductionDb)
+    {
+        raise(inputLevel, inputPeak);
+        raise(outputLevel, outputPeak);
+        raise(gainReduction, gainReductionDb);
+    }
+
+    // Message thread: read the held peaks and start a new hold period
+    float collectInputLevel()       { return inputLevel.exchange(0.0f); }
+    float collectOutputLevel()      { return outputLevel.exchange(0.0f); }
+    float collectGainReduction()    { return gainReduction.exchange(0.0f); }
+
+private:
+    static void raise(atomic<float>& level, float value)
+    {
+        float current = level.load(memory_order_relaxed);
+        while (value > current && ! level.compare_exchange_weak(current, value, memory_order_relaxed)) {}
+    }
+
+    atomic<float> inputLevel    { 0.0f };
+    atomic<float> outputLevel   { 0.0f };
+    atomic<float> gainReduction { 0.0f };
+};
+
+// Detector groups of a bus layout: the channels of a linked group share one detector and one gain.
+// Plain values only, so the audio thread can copy and compare them.
+struct ChannelGroups
+{
+    enum Role { front, surround, height, lfe, numLinkableRoles = lfe };
+    static constexpr int maxChannels = 16;
+
+    static Role getRole(AudioChannelSet::ChannelType type);
+
+    // One group per linked role, one per channel of an unlinked role, LFE channels in none
+    static ChannelGroups make(const Role* roles, int numChannels, const bool* linked);
+
+    // Every channel in one group, as a plain mono or stereo compressor runs
+    static ChannelGroups linkAll(int numChannels);
+
+    int getNumChannels(int group) const     { return groupStart[group + 1] - groupStart[group]; }
+    int getChannel(int group, int index) const  { return channels[groupStart[group] + index]; }
+
+    bool operator== (const ChannelGroups& other) const;
+
+    int numGroups = 0;
+    int groupStart[maxChannels + 1] = {};       // the channels of group g are channels[groupStart[g] .. groupStart[g + 1])
+    int channels[maxChannels] = {};
+};
+
 class Compressor
 {
 public:
@@ -20,9 +75,40 @@ public:
     ~Compressor() {}
     
     void prepareToPlay (double samplerate, int samplesPerBlock, int numInputChannels);
+    void reset();
     void processBlock(AudioSampleBuffer &buffer);
     void setParameters(float ratio, float threshold, float attack, float release, float makeUpGain, float kneeWidth);
 
+    // Audio thread safe: which channels share a detector, every channel is linked after prepareToPlay
+    void setChannelGroups(const ChannelGroups& newGroups)  { groups = newGroups; }
+
+    // Meter the compressor publishes to once per block, if any
+    void setMeter(CompressorMeter* meterToUse) { meter = meterToUse; }
+
+    // Meter reading of a bypassed block: the band passes unchanged, with no gain reduction
+    void publishBypass(const AudioSampleBuffer& buffer);
+
+    // Table-based level detection and gain, set from the audio thread when close to overload
+    void setFastMath(bool shouldUseFastMath) { fastMath = shouldUseFastMath; }
+
+    // Static input/output curve in dB, incorporating the SOFT KNEE
+    static float computeOutputGain(float inputGain, float threshold, float ratio, float kneeWidth)
+    {
+        if (2 * (inputGain - threshold) >= kneeWidth)
+        {
+            // above knee
+            return threshold + (inputGain - threshold) / ratio;
+        }
+        else if (2 * fabs(inputGain - threshold) <= kneeWidth)
+        {
+            // in knee
+            return inputGain + (1 / ratio - 1) * pow(inputGain - threshold + kneeWidth / 2, 2) / (2 * kneeWidth);
+        }
+
+        // below knee
+        return inputGain;
+    }
+
 private:
     // Parameters
     float cRatio;
@@ -33,8 +119,32 @@ private:
     float cKneeWidth;
     float cSampleRate;
 
-    // Compressor ON-OFF state
-    int compressorState = 1;
+    // Ballistics, from the attack and release times at the current sample rate
+    float alphaAttack = 0;
+    float alphaRelease = 0;
+    void updateBallistics();
+
+    // Smoothed parameters, ramped per sample while they move.
+    // The ramps are stepped once per block into rampBuffer, which every channel group reads.
+    static constexpr double smoothingTime = 0.02;
+    SmoothedValue<float> smoothedThreshold;
+    SmoothedValue<float> smoothedRatio;
+    SmoothedValue<float> smoothedMakeUpGain;
+    SmoothedValue<float> smoothedKneeWidth;
+    bool parametersInitialised = false;
+
+    enum Ramp { thresholdRamp = 0, ratioRamp, kneeWidthRamp, makeUpGainRamp, numRamps };
+    AudioSampleBuffer rampBuffer;
+    void fillRamps(int numSamples);
+
+    // Detector levels of one channel group to its gains, in place, from the ramps or the static values.
+    // A per-sample recursion through log10 and pow, so it stays scalar; the detector and the gain stage around it are vectorised.
+    template <bool rampParameters>
+    float compressGroup(float* detector, int numSamples, float previousLevel, float& maxGainReduction);
+
+    // Fast Math, with the tables shared by every compressor in the process
+    bool fastMath = false;
+    SharedResourcePointer<DecibelTables> decibelTables;
 
     // Gain and Levels
     float inputGain;
@@ -42,9 +152,17 @@ private:
     float outputGain;
     float outputLevel;
 
-    float previousOutputLevel;
+    // Ballistics state of each detector
+    float previousOutputLevel[ChannelGroups::maxChannels];
     
     float controlVoltage;
+
+    // Detector input, then gain, of each channel group, and a channel to rectify into, sized in prepareToPlay
+    ChannelGroups groups;
+    AudioSampleBuffer inputBuffer;
+
+    // Input, Output and Gain Reduction Meter
+    CompressorMeter* meter = nullptr;
 };
 
 #endif /* Compressor_h */
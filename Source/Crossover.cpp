@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    This file contains the three-band crossover: two cascaded second order
+    state variable sections per slope, for any number of channels. Layouts of four or more
+    channels run the sections on several channels at once, one per SIMD lane.
+
+  ==============================================================================
+*/
+
+#include "Crossover.h"
+
+using namespace std;
+using namespace juce;
+
+void Crossover::prepare(double sampleRate, int numChannels)
+{
+    cSampleRate = sampleRate;
+    channels.assign((size_t) jmax(0, numChannels), ChannelState());
+
+   #if JUCE_USE_SIMD
+    // Whole groups of lanes only, the channels left over use the scalar sections
+    lanes.assign((size_t) jmax(0, numChannels / numLanes), LaneState());
+   #endif
+}
+
+void Crossover::reset()
+{
+    for (auto& channel : channels)
+        channel = ChannelState();
+
+   #if JUCE_USE_SIMD
+    for (auto& state : lanes)
+        state = LaneState();
+   #endif
+}
+
+Crossover::StateVariable Crossover::StateVariable::make(double sampleRate, float cutOff)
+{
+    // The same prewarped cutoff as the bilinear biquad, kept below Nyquist
+    const double frequency = jlimit(1.0, 0.49 * sampleRate, (double) cutOff);
+    return fromWarpedCutoff(tan(MathConstants<double>::pi * frequency / sampleRate));
+}
+
+Crossover::StateVariable Crossover::StateVariable::fromWarpedCutoff(double g)
+{
+    StateVariable result;
+    const double a1 = 1.0 / (1.0 + g * (g + (double) damping));
+    result.g = g;
+    result.a1 = (float) a1;
+    result.a2 = (float) (g * a1);
+    result.a3 = (float) (g * g * a1);
+    return result;
+}
+
+complex<double> Crossover::StateVariable::getResponse(bool highPass, double omega) const
+{
+    // The trapezoidal section is the bilinear transform of 1 / (s^2 + k s + 1), prewarped by g
+    const complex<double> z1 = polar(1.0, -omega);
+    const complex<double> z2 = z1 * z1;
+    const double k = (double) damping;
+    const complex<double> denominator = (1.0 + k * g + g * g) + 2.0 * (g * g - 1.0) * z1 + (1.0 - k * g + g * g) * z2;
+
+    return (highPass ? (1.0 - z1) * (1.0 - z1) : g * g * (1.0 + z1) * (1.0 + z1)) / denominator;
+}
+
+Crossover::Coefficients Crossover::Coefficients::make(double sampleRate, float lowCutOff, float highCutOff)
+{
+    return { StateVariable::make(sampleRate, lowCutOff), StateVariable::make(sampleRate, highCutOff) };
+}
+
+Crossover::Coefficients Crossover::Coefficients::interpolate(const Coefficients& from, const Coefficients& to, float amount)
+{
+    auto mix = [amount] (const StateVariable& a, const StateVariable& b)
+    {
+        return StateVariable::fromWarpedCutoff(a.g + amount * (b.g - a.g));
+    };
+
+    return { mix(from.lowCut, to.lowCut), mix(from.highCut, to.highCut) };
+}
+
+void Crossover::Coefficients::getBandResponses(double omega, complex<double>& low, complex<double>& mid, complex<double>& high) const
+{
+    // Each band runs two identical stages per slope
+    low = pow(lowCut.getResponse(false, omega), 2);
+    mid = pow(lowCut.getResponse(true, omega) * highCut.getResponse(false, omega), 2);
+    high = pow(highCut.getResponse(true, omega), 2);
+}
+
+void Crossover::setCutoffs(float lowCutOff, float highCutOff)
+{
+    coefficients = Coefficients::make(cSampleRate, lowCutOff, highCutOff);
+}
+
+void Crossover::process(AudioSampleBuffer& low, AudioSampleBuffer& mid, AudioSampleBuffer& high, int numChannels, int numSamples)
+{
+    numChannels = jmin(numChannels, (int) channels.size());
+    int channel = 0;
+
+   #if JUCE_USE_SIMD
+    // Surround layouts: a register's worth of channels at a time, stereo never gets here
+    for (auto& state : lanes)
+    {
+        if (channel + numLanes > numChannels)
+            break;
+
+        processLanes(state, low, mid, high, channel, numSamples);
+        channel += numLanes;
+    }
+   #endif
+
+    for (; channel < numChannels; channel++)
+    {
+        auto& state = channels[(size_t) channel];
+
+        // Low Band Filtering Stages
+        state.lowBand1.process<false>(coefficients.lowCut, low.getWritePointer(channel), numSamples);
+        state.lowBand2.process<false>(coefficients.lowCut, low.getWritePointer(channel), numSamples);
+
+        // Low - Mid and High - Mid Band Filtering Stages
+        state.lowMidBand1.process<true>(coefficients.lowCut, mid.getWritePointer(channel), numSamples);
+        state.lowMidBand2.process<true>(coefficients.lowCut, mid.getWritePointer(channel), numSamples);
+        state.highMidBand1.process<false>(coefficients.highCut, mid.getWritePointer(channel), numSamples);
+        state.highMidBand2.process<false>(coefficients.highCut, mid.getWritePointer(channel), numSamples);
+
+        // High Band Filtering Stages
+        state.highBand1.process<true>(coefficients.highCut, high.getWritePointer(channel), numSamples);
+        state.highBand2.process<true>(coefficients.highCut, high.getWritePointer(channel), numSamples);
+    }
+}
+
+#if JUCE_USE_SIMD
+void Crossover::processLanes(LaneState& state, AudioSampleBuffer& low, AudioSampleBuffer& mid, AudioSampleBuffer& high, int firstChannel, int numSamples)
+{
+    const LaneCoefficients lowCut(coefficients.lowCut), highCut(coefficients.highCut);
+
+    float* lowData[numLanes];
+    float* midData[numLanes];
+    float* highData[numLanes];
+    for (int lane = 0; lane < numLanes; lane++)
+    {
+        lowData[lane] = low.getWritePointer(firstChannel + lane);
+        midData[lane] = mid.getWritePointer(firstChannel + lane);
+        highData[lane] = high.getWritePointer(firstChannel + lane);
+    }
+
+    alignas(Lanes::SIMDRegisterSize) float frame[numLanes];
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        // The band buffers hold the same input, so it is gathered once
+        for (int lane = 0; lane < numLanes; lane++)
+            frame[lane] = lowData[lane][i];
+
+        const Lanes in = Lanes::fromRawArray(frame);
+
+        // Low Band Filtering Stages
+        const Lanes lowOut = state.lowBand2.process<false>(lowCut, state.lowBand1.process<false>(lowCut, in));
+
+        // Low - Mid and High - Mid Band Filtering Stages
+        Lanes midOut = state.lowMidBand2.process<true>(lowCut, state.lowMidBand1.process<true>(lowCut, in));
+        midOut = state.highMidBand2.process<false>(highCut, state.highMidBand1.process<false>(highCut, midOut));
+
+        // High Band Filtering Stages
+        const Lanes highOut = state.highBand2.process<true>(highCut, state.highBand1.process<true>(highCut, in));
+
+        lowOut.copyToRawArray(frame);
+        for (int lane = 0; lane < numLanes; lane++)
+            lowData[lane][i] = frame[lane];
+
+        midOut.copyToRawArray(frame);
+        for (int lane = 0; lane < numLanes; lane++)
+            midData[lane][i] = frame[lane];
+
+        highOut.copyToRawArray(frame);
+        for (int lane = 0; lane < numLanes; lane++)
+            highData[lane][i] = frame[lane];
+    }
+
+    for (auto* section : { &state.lowBand1, &state.lowBand2, &state.lowMidBand1, &state.lowMidBand2,
+                           &state.highMidBand1, &state.highMidBand2, &state.highBand1, &state.highBand2 })
+        section->snapToZero();
+}
+#endif
@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    This file contains the three-band crossover: two cascaded second order
+    state variable sections per slope, for any number of channels. Layouts of four or more
+    channels run the sections on several channels at once, one per SIMD lane.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+class Crossover
+{
+public:
+    // One cutoff of the state variable sections, designed in double precision.
+    // g = tan(pi fc / fs) and the Butterworth damping give the response of the bilinear biquad,
+    // while the coefficients stay far from cancellation at low cutoffs and high sample rates.
+    struct StateVariable
+    {
+        float a1 = 1, a2 = 0, a3 = 0;
+        double g = 0;
+
+        static constexpr float damping = MathConstants<float>::sqrt2;
+
+        static StateVariable make(double sampleRate, float cutOff);
+        static StateVariable fromWarpedCutoff(double g);
+
+        // Complex response of one low or high pass section at the normalised frequency omega
+        complex<double> getResponse(bool highPass, double omega) const;
+    };
+
+    // Coefficient values for one pair of cutoffs, shared by every channel
+    struct Coefficients
+    {
+        StateVariable lowCut, highCut;
+
+        static Coefficients make(double sampleRate, float lowCutOff, float highCutOff);
+
+        // Blend of the warped cutoffs of two sets. A state variable section is stable for any positive cutoff.
+        static Coefficients interpolate(const Coefficients& from, const Coefficients& to, float amount);
+
+        // Complex response of each band at the normalised frequency omega, through the same stages as process()
+        void getBandResponses(double omega, complex<double>& low, complex<double>& mid, complex<double>& high) const;
+    };
+
+    Crossover() {}
+    ~Crossover() {}
+
+    // Allocates the filter states, call before processing
+    void prepare(double sampleRate, int numChannels);
+    void reset();
+
+    // Audio thread safe: recomputes the coefficients without locking or allocating
+    void setCutoffs(float lowCutOff, float highCutOff);
+
+    // Audio thread safe: takes coefficients computed elsewhere, for the same sample rate
+    void setCoefficients(const Coefficients& newCoefficients)  { coefficients = newCoefficients; }
+    const Coefficients& getCoefficients() const                 { return coefficients; }
+
+    // Filters the band buffers in place, each one holding a copy of the input
+    void process(AudioSampleBuffer& low, AudioSampleBuffer& mid, AudioSampleBuffer& high, int numChannels, int numSamples);
+
+private:
+    // Topology-preserving state variable section (trapezoidal integrators), low or high pass output
+    struct Section
+    {
+        float s1 = 0, s2 = 0;
+
+        template <bool highPass>
+        void process(const StateVariable& c, float* samples, int numSamples)
+        {
+            const float a1 = c.a1, a2 = c.a2, a3 = c.a3;
+            float ls1 = s1, ls2 = s2;
+
+            for (int i = 0; i < numSamples; i++)
+            {
+                const float in = samples[i];
+                const float v3 = in - ls2;
+                const float v1 = a1 * ls1 + a2 * v3;
+                const float v2 = ls2 + a2 * ls1 + a3 * v3;
+                ls1 = 2 * v1 - ls1;
+                ls2 = 2 * v2 - ls2;
+
+                samples[i] = highPass ? in - StateVariable::damping * v1 - v2 : v2;
+            }
+
+            JUCE_SNAP_TO_ZERO(ls1);  s1 = ls1;
+            JUCE_SNAP_TO_ZERO(ls2);  s2 = ls2;
+        }
+    };
+
+    // Filter Stages of one channel
+    struct ChannelState
+    {
+        Section lowBand1,       lowBand2;
+        Section lowMidBand1,    lowMidBand2;
+        Section highMidBand1,   highMidBand2;
+        Section highBand1,      highBand2;
+    };
+
+    vector<ChannelState> channels;
+    double cSampleRate = 44100.0;
+
+   #if JUCE_USE_SIMD
+    // The same sections for as many channels as a register holds, one channel per lane
+    using Lanes = dsp::SIMDRegister<float>;
+    static constexpr int numLanes = (int) Lanes::SIMDNumElements;
+
+    struct LaneCoefficients
+    {
+        explicit LaneCoefficients(const StateVariable& c)
+            : a1(Lanes::expand(c.a1)), a2(Lanes::expand(c.a2)), a3(Lanes::expand(c.a3)) {}
+
+        Lanes a1, a2, a3;
+    };
+
+    struct LaneSection
+    {
+        Lanes s1 = Lanes::expand(0.0f), s2 = Lanes::expand(0.0f);
+
+        // One sample of every lane, with the arithmetic of Section
+        template <bool highPass>
+        forcedinline Lanes process(const LaneCoefficients& c, Lanes in) noexcept
+        {
+            const Lanes v3 = in - s2;
+            const Lanes v1 = c.a1 * s1 + c.a2 * v3;
+            const Lanes v2 = s2 + c.a2 * s1 + c.a3 * v3;
+            s1 = v1 + v1 - s1;
+            s2 = v2 + v2 - s2;
+
+            return highPass ? in - Lanes::expand(StateVariable::damping) * v1 - v2 : v2;
+        }
+
+        void snapToZero() noexcept
+        {
+            for (size_t lane = 0; lane < Lanes::size(); lane++)
+            {
+                float ls1 = s1.get(lane), ls2 = s2.get(lane);
+                JUCE_SNAP_TO_ZERO(ls1);  s1.set(lane, ls1);
+                JUCE_SNAP_TO_ZERO(ls2);  s2.set(lane, ls2);
+            }
+        }
+    };
+
+    // Filter Stages of numLanes consecutive channels
+    struct LaneState
+    {
+        LaneSection lowBand1,       lowBand2;
+        LaneSection lowMidBand1,    lowMidBand2;
+        LaneSection highMidBand1,   highMidBand2;
+        LaneSection highBand1,      highBand2;
+    };
+
+    vector<LaneState> lanes;
+
+    void processLanes(LaneState& state, AudioSampleBuffer& low, AudioSampleBuffer& mid, AudioSampleBuffer& high, int firstChannel, int numSamples);
+   #endif
+
+    Coefficients coefficients;
+};
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    This file contains table-based decibel conversions, the fast math used by
+    the compressor when the plugin is close to overload.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+// log2 and exp2 over one octave, linearly interpolated: within 0.0001 dB of the exact functions
+class DecibelTables
+{
+public:
+    DecibelTables()
+    {
+        for (int i = 0; i <= tableSize; i++)
+        {
+            log2Table[i] = (float) log2(1.0 + (double) i / tableSize);
+            exp2Table[i] = (float) exp2((double) i / tableSize);
+        }
+    }
+
+    // 20 log10 |gain|, or floorDb below the silence level
+    float gainToDecibels(float gain, float floorDb, float silenceLevel) const
+    {
+        gain = fabs(gain);
+        if (gain < silenceLevel)
+            return floorDb;
+
+        // gain = mantissa * 2^exponent with the mantissa in [0.5, 1)
+        int exponent;
+        const float mantissa = frexp(gain, &exponent);
+        const float position = (mantissa * 2.0f - 1.0f) * tableSize;
+        const int index = jmin((int) position, tableSize - 1);
+        const float fraction = position - (float) index;
+
+        const float octaves = (float) (exponent - 1) + log2Table[index] + fraction * (log2Table[index + 1] - log2Table[index]);
+        return octaves * decibelsPerOctave;
+    }
+
+    // 10^(decibels / 20)
+    float decibelsToGain(float decibels) const
+    {
+        const float octaves = decibels / decibelsPerOctave;
+        const float whole = floor(octaves);
+        const float position = (octaves - whole) * tableSize;
+        const int index = jlimit(0, tableSize - 1, (int) position);
+        const float fraction = position - (float) index;
+
+        return ldexp(exp2Table[index] + fraction * (exp2Table[index + 1] - exp2Table[index]), (int) whole);
+    }
+
+private:
+    static constexpr int tableSize = 1024;
+    static constexpr float decibelsPerOctave = 6.0205999f;     // 20 log10(2)
+
+    float log2Table[tableSize + 1];
+    float exp2Table[tableSize + 1];
+};
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    This file contains the input, output and gain reduction meter of a band.
+
+  ==============================================================================
+*/
+
+#include "LevelMeter.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+LevelMeter::LevelMeter(CompressorMeter& meterToDisplay)
+    : meter(meterToDisplay)
+{
+    setInterceptsMouseClicks(false, false);
+}
+
+LevelMeter::~LevelMeter()
+{
+}
+
+void LevelMeter::update()
+{
+    // Peaks jump up immediately and fall back at a fixed rate
+    const float newInput = Decibels::gainToDecibels(meter.collectInputLevel(), minimumLevel);
+    const float newOutput = Decibels::gainToDecibels(meter.collectOutputLevel(), minimumLevel);
+    const float newReduction = meter.collectGainReduction();
+
+    // The fall rate does not depend on how often update() is called
+    const double now = Time::getMillisecondCounterHiRes();
+    const float fall = lastUpdateTime > 0 ? (float) (fallPerSecond * (now - lastUpdateTime) * 0.001) : 0.0f;
+    lastUpdateTime = now;
+
+    const float input = jmax(newInput, inputLevel - fall);
+    const float output = jmax(newOutput, outputLevel - fall);
+    const float reduction = jmax(newReduction, gainReduction - fall, 0.0f);
+
+    if (input == inputLevel && output == outputLevel && reduction == gainReduction)
+        return;
+
+    inputLevel = input;
+    outputLevel = output;
+    gainReduction = reduction;
+    repaint();
+}
+
+void LevelMeter::paint(Graphics& g)
+{
+    // Input, Output and Gain Reduction bars side by side
+    auto area = getLocalBounds().toFloat();
+    const float barWidth = area.getWidth() / 3.0f;
+
+    drawBar(g, area.removeFromLeft(barWidth).reduced(1.0f), jmap(inputLevel, minimumLevel, 0.0f, 0.0f, 1.0f), false);
+    drawBar(g, area.removeFromLeft(barWidth).reduced(1.0f), jmap(outputLevel, minimumLevel, 0.0f, 0.0f, 1.0f), false);
+
+    drawBar(g, area.reduced(1.0f), jlimit(0.0f, 1.0f, gainReduction / -minimumLevel), true);
+}
+
+void LevelMeter::drawBar(Graphics& g, Rectangle<float> area, float proportion, bool fromTop)
+{
+    g.setColour(Colours::white.withAlpha(0.15f));
+    g.fillRect(area);
+
+    const float height = area.getHeight() * jlimit(0.0f, 1.0f, proportion);
+    g.setColour(fromTop ? Colours::orange : Colours::lightblue);
+    g.fillRect(fromTop ? area.removeFromTop(height) : area.removeFromBottom(height));
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    This file contains the input, output and gain reduction meter of a band.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Compressor.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+class LevelMeter  : public Component
+{
+public:
+    LevelMeter(CompressorMeter& meterToDisplay);
+    ~LevelMeter() override;
+
+    void paint(Graphics&) override;
+
+    // Collects the held peaks and repaints only if the display moved
+    void update();
+
+private:
+    CompressorMeter& meter;
+
+    // Displayed values in dB, falling back smoothly between peaks
+    float inputLevel = minimumLevel;
+    float outputLevel = minimumLevel;
+    float gainReduction = 0.0f;
+
+    static constexpr float minimumLevel = -60.0f;
+    static constexpr double fallPerSecond = 45.0;
+    double lastUpdateTime = 0;
+
+    void drawBar(Graphics& g, Rectangle<float> area, float proportion, bool fromTop);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeter)
+};
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    This file contains the CPU load estimate of processBlock: the time spent
+    in each block against the real-time budget of its samples.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+// Written by the audio thread, read by the editor and the overload logger without locks
+class LoadMonitor
+{
+public:
+    // Times one processBlock call
+    class ScopedMeasurement
+    {
+    public:
+        ScopedMeasurement(LoadMonitor& m, int n) : monitor(m), numSamples(n), start(Time::getHighResolutionTicks()) {}
+        ~ScopedMeasurement() { monitor.registerBlock(Time::getHighResolutionTicks() - start, numSamples); }
+
+    private:
+        LoadMonitor& monitor;
+        const int numSamples;
+        const int64 start;
+    };
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        secondsPerTick = 1.0 / (double) Time::getHighResolutionTicksPerSecond();
+        averageLoad.store(0.0f);
+        peakLoad.store(0.0f);
+    }
+
+    // Audio thread: load is the fraction of the block's duration spent processing it
+    void registerBlock(int64 ticks, int numSamples)
+    {
+        if (numSamples <= 0 || sampleRate <= 0)
+            return;
+
+        const double budget = numSamples / sampleRate;
+        const float load = (float) ((double) ticks * secondsPerTick / budget);
+
+        // Exponential average with a time constant of averagingTime seconds of audio
+        const float alpha = (float) jmin(1.0, budget / averagingTime);
+        const float average = averageLoad.load(memory_order_relaxed);
+        averageLoad.store(average + alpha * (load - average), memory_order_relaxed);
+
+        float peak = peakLoad.load(memory_order_relaxed);
+        while (load > peak && ! peakLoad.compare_exchange_weak(peak, load, memory_order_relaxed)) {}
+
+        if (load > 1.0f)
+            overloadCount.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Averaged load, 1.0 being the whole budget
+    float getAverageLoad() const    { return averageLoad.load(memory_order_relaxed); }
+
+    // Highest load since the last call
+    float collectPeakLoad()         { return peakLoad.exchange(0.0f); }
+
+    // Blocks that took longer than their own duration
+    int getOverloadCount() const    { return overloadCount.load(memory_order_relaxed); }
+
+private:
+    static constexpr double averagingTime = 0.5;
+
+    double sampleRate = 0;
+    double secondsPerTick = 0;
+
+    atomic<float> averageLoad   { 0.0f };
+    atomic<float> peakLoad      { 0.0f };
+    atomic<int>   overloadCount { 0 };
+};
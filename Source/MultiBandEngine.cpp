@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    This file contains the DSP engine of the plugin: the crossover, the three
+    band compressors and the band summing, with all of their state.
+
+  ==============================================================================
+*/
+
+#include "MultiBandEngine.h"
+
+using namespace std;
+using namespace juce;
+
+void MultiBandEngine::prepare(double sampleRate, int maxBlockSize, int numChannels, const ParameterSnapshot& snapshot)
+{
+    maxBlockSize = jmax(1, maxBlockSize);
+
+    // Prepare the Crossover
+    crossover.prepare(sampleRate, numChannels);
+
+    // Prepare the Compressors
+    lowCompressor.prepareToPlay(sampleRate, maxBlockSize, numChannels);
+    midCompressor.prepareToPlay(sampleRate, maxBlockSize, numChannels);
+    highCompressor.prepareToPlay(sampleRate, maxBlockSize, numChannels);
+
+    // The compressors start with every channel linked, the next setChannelGroups() passes the real groups on
+    channelGroups = ChannelGroups();
+
+    // Allocate the band buffers up front, the audio thread never resizes them
+    lowOutput.setSize(numChannels, maxBlockSize);
+    midOutput.setSize(numChannels, maxBlockSize);
+    highOutput.setSize(numChannels, maxBlockSize);
+    dryOutput.setSize(numChannels, maxBlockSize);
+    rampBuffer.setSize(1, maxBlockSize);
+
+    // Ramp times at the new sample rate
+    overallGain.reset(sampleRate, gainSmoothingTime);
+    lowCompressorMix.reset(sampleRate, bypassFadeTime);
+    midCompressorMix.reset(sampleRate, bypassFadeTime);
+    highCompressorMix.reset(sampleRate, bypassFadeTime);
+
+    reset(snapshot);
+}
+
+void MultiBandEngine::reset(const ParameterSnapshot& snapshot)
+{
+    // Clear the Filter States and Calculate Filter Coefficients
+    crossover.reset();
+    crossover.setCutoffs(snapshot.lowCutOff, snapshot.highCutOff);
+
+    // Initialise the Compressor Parameters
+    lowCompressor.reset();
+    midCompressor.reset();
+    highCompressor.reset();
+    updateCompressorParameters(snapshot);
+    currentSnapshot = snapshot;
+
+    // Start the Overall Gain ramp from its current value
+    overallGain.setCurrentAndTargetValue(snapshot.overallGain);
+
+    // Start the Compressor States where the parameters are
+    lowCompressorMix.setCurrentAndTargetValue(snapshot.low.enabled >= 0.5f ? 1.0f : 0.0f);
+    midCompressorMix.setCurrentAndTargetValue(snapshot.mid.enabled >= 0.5f ? 1.0f : 0.0f);
+    highCompressorMix.setCurrentAndTargetValue(snapshot.high.enabled >= 0.5f ? 1.0f : 0.0f);
+}
+
+void MultiBandEngine::applySettings(const ParameterSnapshot& snapshot, const Crossover::Coefficients& coefficients)
+{
+    crossover.setCoefficients(coefficients);
+
+    if (! (snapshot == currentSnapshot))
+        updateCompressorParameters(snapshot);
+
+    currentSnapshot = snapshot;
+}
+
+void MultiBandEngine::setMeters(CompressorMeter& low, CompressorMeter& mid, CompressorMeter& high)
+{
+    lowMeter = &low;
+    midMeter = &mid;
+    highMeter = &high;
+    applyMeters();
+}
+
+void MultiBandEngine::setMetering(bool shouldMeter)
+{
+    if (shouldMeter == metering)
+        return;
+
+    metering = shouldMeter;
+    applyMeters();
+}
+
+void MultiBandEngine::applyMeters()
+{
+    lowCompressor.setMeter(metering ? lowMeter : nullptr);
+    midCompressor.setMeter(metering ? midMeter : nullptr);
+    highCompressor.setMeter(metering ? highMeter : nullptr);
+}
+
+void MultiBandEngine::setFastMath(bool shouldUseFastMath)
+{
+    lowCompressor.setFastMath(shouldUseFastMath);
+    midCompressor.setFastMath(shouldUseFastMath);
+    highCompressor.setFastMath(shouldUseFastMath);
+}
+
+void MultiBandEngine::setChannelGroups(const ChannelGroups& groups)
+{
+    if (groups == channelGroups)
+        return;
+
+    channelGroups = groups;
+    lowCompressor.setChannelGroups(groups);
+    midCompressor.setChannelGroups(groups);
+    highCompressor.setChannelGroups(groups);
+}
+
+void MultiBandEngine::updateCompressorParameters(const ParameterSnapshot& snapshot)
+{
+    lowCompressor.setParameters(snapshot.low.ratio, snapshot.low.threshold, snapshot.low.attack, snapshot.low.release, snapshot.low.gain, snapshot.kneeWidth);
+    midCompressor.setParameters(snapshot.mid.ratio, snapshot.mid.threshold, snapshot.mid.attack, snapshot.mid.release, snapshot.mid.gain, snapshot.kneeWidth);
+    highCompressor.setParameters(snapshot.high.ratio, snapshot.high.threshold, snapshot.high.attack, snapshot.high.release, snapshot.high.gain, snapshot.kneeWidth);
+}
+
+void MultiBandEngine::process(AudioSampleBuffer& buffer, int startSample, int numSamples, int numInputChannels, const ParameterSnapshot& snapshot)
+{
+    //=========================VARIABLES====================================================================//
+    const int numBufferChannels = jmin(buffer.getNumChannels(), lowOutput.getNumChannels());
+    jassert(numSamples <= lowOutput.getNumSamples());
+    MBC_PROFILE_BEGIN(*profiler);
+
+    //===========================DSP PROCESSING STARTS HERE====================================================//
+
+    // Recalculate the coefficients only when the cutoffs are altered
+    if (snapshot.lowCutOff != currentSnapshot.lowCutOff || snapshot.highCutOff != currentSnapshot.highCutOff)
+        crossover.setCutoffs(snapshot.lowCutOff, snapshot.highCutOff);
+
+    // Set the Compressor Parameters only when they are altered
+    if (! (snapshot == currentSnapshot))
+        updateCompressorParameters(snapshot);
+
+    currentSnapshot = snapshot;
+    MBC_PROFILE_LAP(coefficients);
+
+    // Set each buffer to an input
+    for (int channel = 0; channel < numBufferChannels; channel++)
+    {
+        lowOutput.copyFrom(channel, 0, buffer, channel, startSample, numSamples);
+        midOutput.copyFrom(channel, 0, buffer, channel, startSample, numSamples);
+        highOutput.copyFrom(channel, 0, buffer, channel, startSample, numSamples);
+    }
+
+    // Apply Filter onto the buffer
+    crossover.process(lowOutput, midOutput, highOutput, numBufferChannels, numSamples);
+    MBC_PROFILE_LAP(filtering);
+
+    // Views of the band buffers covering this sub-block only
+    AudioSampleBuffer lowBlock(lowOutput.getArrayOfWritePointers(), numBufferChannels, 0, numSamples);
+    AudioSampleBuffer midBlock(midOutput.getArrayOfWritePointers(), numBufferChannels, 0, numSamples);
+    AudioSampleBuffer highBlock(highOutput.getArrayOfWritePointers(), numBufferChannels, 0, numSamples);
+
+    // Compress Each Band
+    processBand(lowCompressor, lowCompressorMix, snapshot.low.enabled >= 0.5f, lowBlock);
+    processBand(midCompressor, midCompressorMix, snapshot.mid.enabled >= 0.5f, midBlock);
+    processBand(highCompressor, highCompressorMix, snapshot.high.enabled >= 0.5f, highBlock);
+    MBC_PROFILE_LAP(compression);
+
+    // Sum Each Band
+    buffer.clear(startSample, numSamples);
+    for (int channel = 0; channel < numInputChannels; channel++)
+    {
+        buffer.addFrom(channel, startSample, lowOutput, channel, 0, numSamples, 1.0 / 3.0);
+        buffer.addFrom(channel, startSample, midOutput, channel, 0, numSamples, 1.0 / 3.0);
+        buffer.addFrom(channel, startSample, highOutput, channel, 0, numSamples, 1.0 / 3.0);
+    }
+
+    // Apply the Overall Gain, as a ramp only while it is moving
+    overallGain.setTargetValue(snapshot.overallGain);
+    if (overallGain.isSmoothing())
+    {
+        const float* gains = fillRamp(overallGain, numSamples);
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+            FloatVectorOperations::multiply(buffer.getWritePointer(channel, startSample), gains, numSamples);
+    }
+    else
+    {
+        buffer.applyGain(startSample, numSamples, overallGain.getTargetValue());
+    }
+
+    MBC_PROFILE_LAP(summing);
+}
+
+void MultiBandEngine::processBand(Compressor& compressor, SmoothedValue<float>& compressorMix, bool enabled, AudioSampleBuffer& band)
+{
+    const int numSamples = band.getNumSamples();
+    compressorMix.setTargetValue(enabled ? 1.0f : 0.0f);
+
+    // Settled: either fully compressed or fully bypassed, a bypassed band still meters 0 dB of gain reduction
+    if (! compressorMix.isSmoothing())
+    {
+        if (compressorMix.getTargetValue() > 0.5f)
+            compressor.processBlock(band);
+        else
+            compressor.publishBypass(band);
+        return;
+    }
+
+    // Switching: crossfade from the dry band to the compressed band or back
+    for (int channel = 0; channel < band.getNumChannels(); channel++)
+        dryOutput.copyFrom(channel, 0, band, channel, 0, numSamples);
+
+    compressor.processBlock(band);
+
+    // dry + mix * (compressed - dry)
+    const float* mixes = fillRamp(compressorMix, numSamples);
+    for (int channel = 0; channel < band.getNumChannels(); channel++)
+    {
+        float* samples = band.getWritePointer(channel);
+        const float* dry = dryOutput.getReadPointer(channel);
+        FloatVectorOperations::subtract(samples, dry, numSamples);
+        FloatVectorOperations::multiply(samples, mixes, numSamples);
+        FloatVectorOperations::add(samples, dry, numSamples);
+    }
+}
+
+const float* MultiBandEngine::fillRamp(SmoothedValue<float>& value, int numSamples)
+{
+    // Stepped per sample, so a ramp ends on the same sample however the sub-blocks are split
+    float* ramp = rampBuffer.getWritePointer(0);
+    for (int i = 0; i < numSamples; i++)
+        ramp[i] = value.getNextValue();
+
+    return ramp;
+}
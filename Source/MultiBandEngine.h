@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    This file contains the DSP engine of the plugin: the crossover, the three
+    band compressors and the band summing, with all of their state.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Compressor.h"
+#include "Crossover.h"
+#include "Parameters.h"
+#include "StageProfiler.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+class MultiBandEngine
+{
+public:
+    MultiBandEngine() {}
+    ~MultiBandEngine() {}
+
+    // Allocates every buffer and starts from silence at the given values
+    void prepare(double sampleRate, int maxBlockSize, int numChannels, const ParameterSnapshot& snapshot);
+
+    // Back to silence at the given values, with the buffers and sample rate of the last prepare and without allocating.
+    // Only while no other thread runs this engine.
+    void reset(const ParameterSnapshot& snapshot);
+
+    // Processes numSamples (at most maxBlockSize) of buffer in place, from startSample
+    void process(AudioSampleBuffer& buffer, int startSample, int numSamples, int numInputChannels, const ParameterSnapshot& snapshot);
+
+    // Values and crossover coefficients the engine is running with
+    const ParameterSnapshot& getSnapshot() const                { return currentSnapshot; }
+    const Crossover::Coefficients& getCoefficients() const      { return crossover.getCoefficients(); }
+
+    // Audio thread: jumps to values whose coefficients were computed beforehand, the filter states carry on
+    void applySettings(const ParameterSnapshot& snapshot, const Crossover::Coefficients& coefficients);
+
+    // Band Meters, shared by every engine of the processor. Audio thread: only the engine that is heard publishes.
+    void setMeters(CompressorMeter& low, CompressorMeter& mid, CompressorMeter& high);
+    void setMetering(bool shouldMeter);
+
+    void setFastMath(bool shouldUseFastMath);
+
+    // Audio thread: detector linking of the bus layout, passed on only when it changed
+    void setChannelGroups(const ChannelGroups& groups);
+
+   #if MBC_ENABLE_PROFILING
+    void setProfiler(StageProfiler& profilerToUse) { profiler = &profilerToUse; }
+   #endif
+
+private:
+    // Low, Mid and High Band Filters for every channel
+    Crossover   crossover;
+
+    // Band Buffers, sized in prepare
+    AudioSampleBuffer   lowOutput;
+    AudioSampleBuffer   midOutput;
+    AudioSampleBuffer   highOutput;
+    AudioSampleBuffer   dryOutput;
+    AudioSampleBuffer   rampBuffer;     // one ramp at a time, of the overall gain or a band's compressor mix
+
+    // Compressors
+    Compressor   lowCompressor;
+    Compressor   midCompressor;
+    Compressor   highCompressor;
+
+    // Band Meters
+    CompressorMeter*            lowMeter = nullptr;
+    CompressorMeter*            midMeter = nullptr;
+    CompressorMeter*            highMeter = nullptr;
+    bool                        metering = true;
+
+    // Parameters
+    ParameterSnapshot           currentSnapshot {};
+    ChannelGroups               channelGroups;
+
+    // Overall Gain ramp
+    static constexpr double     gainSmoothingTime = 0.02;
+    SmoothedValue<float>        overallGain;
+
+    // Compressor States, crossfaded between bypassed (0) and active (1)
+    static constexpr double     bypassFadeTime = 0.01;
+    SmoothedValue<float>        lowCompressorMix;
+    SmoothedValue<float>        midCompressorMix;
+    SmoothedValue<float>        highCompressorMix;
+
+   #if MBC_ENABLE_PROFILING
+    // Stage Timing
+    StageProfiler*              profiler = nullptr;
+   #endif
+
+    void updateCompressorParameters(const ParameterSnapshot& snapshot);
+    void applyMeters();
+    void processBand(Compressor& compressor, SmoothedValue<float>& compressorMix, bool enabled, AudioSampleBuffer& band);
+    const float* fillRamp(SmoothedValue<float>& value, int numSamples);
+
+    JUCE_DECLARE_NON_COPYABLE (MultiBandEngine)
+};
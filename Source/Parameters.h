@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    This file contains the cached parameter handles and the per-block
+    parameter snapshot used by the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+// Plain values of one compressor band, read on each grid line
+struct BandParameters
+{
+    float threshold;
+    float ratio;
+    float attack;
+    float release;
+    float gain;
+    float enabled;
+
+    bool operator== (const BandParameters& other) const
+    {
+        return threshold == other.threshold && ratio == other.ratio && attack == other.attack
+            && release == other.release && gain == other.gain && enabled == other.enabled;
+    }
+};
+
+// Plain values of every parameter, read on each grid line
+struct ParameterSnapshot
+{
+    // Cutoff Frequencies
+    float lowCutOff;
+    float highCutOff;
+
+    // Knee Width and Overall Gain
+    float kneeWidth;
+    float overallGain;
+
+    // Compressor Parameters
+    BandParameters low;
+    BandParameters mid;
+    BandParameters high;
+
+    bool operator== (const ParameterSnapshot& other) const
+    {
+        return lowCutOff == other.lowCutOff && highCutOff == other.highCutOff
+            && kneeWidth == other.kneeWidth && overallGain == other.overallGain
+            && low == other.low && mid == other.mid && high == other.high;
+    }
+};
+
+// Values part way between two snapshots, band states switch halfway
+inline ParameterSnapshot interpolate(const ParameterSnapshot& from, const ParameterSnapshot& to, float amount)
+{
+    auto mix = [amount] (float a, float b) { return a + amount * (b - a); };
+    auto mixBand = [&] (const BandParameters& a, const BandParameters& b) -> BandParameters
+    {
+        return { mix(a.threshold, b.threshold), mix(a.ratio, b.ratio), mix(a.attack, b.attack),
+                 mix(a.release, b.release), mix(a.gain, b.gain), amount < 0.5f ? a.enabled : b.enabled };
+    };
+
+    return { mix(from.lowCutOff, to.lowCutOff), mix(from.highCutOff, to.highCutOff),
+             mix(from.kneeWidth, to.kneeWidth), mix(from.overallGain, to.overallGain),
+             mixBand(from.low, to.low), mixBand(from.mid, to.mid), mixBand(from.high, to.high) };
+}
+
+// Per value: live where it moved away from reference, held otherwise
+inline ParameterSnapshot takeChanged(const ParameterSnapshot& held, const ParameterSnapshot& reference, const ParameterSnapshot& live)
+{
+    auto pick = [] (float h, float r, float l) { return l != r ? l : h; };
+    auto pickBand = [&] (const BandParameters& h, const BandParameters& r, const BandParameters& l) -> BandParameters
+    {
+        return { pick(h.threshold, r.threshold, l.threshold), pick(h.ratio, r.ratio, l.ratio), pick(h.attack, r.attack, l.attack),
+                 pick(h.release, r.release, l.release), pick(h.gain, r.gain, l.gain), pick(h.enabled, r.enabled, l.enabled) };
+    };
+
+    return { pick(held.lowCutOff, reference.lowCutOff, live.lowCutOff), pick(held.highCutOff, reference.highCutOff, live.highCutOff),
+             pick(held.kneeWidth, reference.kneeWidth, live.kneeWidth), pick(held.overallGain, reference.overallGain, live.overallGain),
+             pickBand(held.low, reference.low, live.low), pickBand(held.mid, reference.mid, live.mid), pickBand(held.high, reference.high, live.high) };
+}
+
+// Calls visit(parameterID, value) for every value of a snapshot, message thread only
+template <typename Snapshot, typename Visitor>
+void visitParameters(Snapshot& snapshot, Visitor&& visit)
+{
+    visit("lowCutOff", snapshot.lowCutOff);
+    visit("highCutOff", snapshot.highCutOff);
+    visit("kneeWidth", snapshot.kneeWidth);
+    visit("overallGain", snapshot.overallGain);
+
+    auto visitBand = [&visit] (const String& band, auto& values)
+    {
+        visit(band + "Thresh", values.threshold);
+        visit(band + "Ratio", values.ratio);
+        visit(band + "Attack", values.attack);
+        visit(band + "Release", values.release);
+        visit(band + "Gain", values.gain);
+        visit(band + "Enabled", values.enabled);
+    };
+
+    visitBand("low", snapshot.low);
+    visitBand("mid", snapshot.mid);
+    visitBand("high", snapshot.high);
+}
+
+//==============================================================================
+// Raw parameter pointers for one compressor band
+struct BandParameterHandles
+{
+    atomic<float>* threshold    = nullptr;
+    atomic<float>* ratio        = nullptr;
+    atomic<float>* attack       = nullptr;
+    atomic<float>* release      = nullptr;
+    atomic<float>* gain         = nullptr;
+    atomic<float>* enabled      = nullptr;
+
+    void resolve(AudioProcessorValueTreeState& parameters, const String& band)
+    {
+        threshold   = parameters.getRawParameterValue(band + "Thresh");
+        ratio       = parameters.getRawParameterValue(band + "Ratio");
+        attack      = parameters.getRawParameterValue(band + "Attack");
+        release     = parameters.getRawParameterValue(band + "Release");
+        gain        = parameters.getRawParameterValue(band + "Gain");
+        enabled     = parameters.getRawParameterValue(band + "Enabled");
+    }
+
+    BandParameters load() const
+    {
+        return { threshold->load(), ratio->load(), attack->load(), release->load(), gain->load(), enabled->load() };
+    }
+};
+
+// Raw parameter pointers, resolved once so the audio thread never looks up a parameter by name
+struct ParameterHandles
+{
+    atomic<float>* lowCutOff    = nullptr;
+    atomic<float>* highCutOff   = nullptr;
+    atomic<float>* kneeWidth    = nullptr;
+    atomic<float>* overallGain  = nullptr;
+
+    BandParameterHandles low;
+    BandParameterHandles mid;
+    BandParameterHandles high;
+
+    void resolve(AudioProcessorValueTreeState& parameters)
+    {
+        lowCutOff   = parameters.getRawParameterValue("lowCutOff");
+        highCutOff  = parameters.getRawParameterValue("highCutOff");
+        kneeWidth   = parameters.getRawParameterValue("kneeWidth");
+        overallGain = parameters.getRawParameterValue("overallGain");
+
+        low.resolve(parameters, "low");
+        mid.resolve(parameters, "mid");
+        high.resolve(parameters, "high");
+
+        jassert(lowCutOff != nullptr && highCutOff != nullptr && kneeWidth != nullptr && overallGain != nullptr);
+    }
+
+    ParameterSnapshot load() const
+    {
+        return { lowCutOff->load(), highCutOff->load(), kneeWidth->load(), overallGain->load(),
+                 low.load(), mid.load(), high.load() };
+    }
+};
@@ -14,16 +14,39 @@ using namespace juce;
 
 //==============================================================================
 MultiBandCompressorAudioProcessorEditor::MultiBandCompressorAudioProcessorEditor (MultiBandCompressorAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p),
+      lowMeter (p.getLowMeter()), midMeter (p.getMidMeter()), highMeter (p.getHighMeter()),
+      spectrumDisplay (p.getAnalyser())
 {
 
+    setOpaque(true);
+    setWantsKeyboardFocus(true);
     buildElements();
+    audioProcessor.getAnalyser().startAnalysis();
     setSize(1400, 670);
-    startTimer(100);
+
+    // A/B buttons follow the slot parameter
+    slotParameter = audioProcessor.parameters.getRawParameterValue("abSlot");
+
+    // Undo and Redo follow the undo history
+    audioProcessor.undoManager.addChangeListener(this);
+    changeListenerCallback(&audioProcessor.undoManager);
 }
 
 MultiBandCompressorAudioProcessorEditor::~MultiBandCompressorAudioProcessorEditor()
 {
+    audioProcessor.getAnalyser().stopAnalysis();
+    audioProcessor.undoManager.removeChangeListener(this);
+
+    if (listeningToParameters)
+        for (auto* parameter : audioProcessor.getParameters())
+            if (auto* parameterWithID = dynamic_cast<AudioProcessorParameterWithID*>(parameter))
+                audioProcessor.parameters.removeParameterListener(parameterWithID->paramID, this);
+
+    lowCompressorStateVal = nullptr;
+    midCompressorStateVal = nullptr;
+    highCompressorStateVal = nullptr;
+
     buttonLowCompressorState = nullptr;
     buttonMidCompressorState = nullptr;
     buttonHighCompressorState = nullptr;
@@ -32,8 +55,34 @@ MultiBandCompressorAudioProcessorEditor::~MultiBandCompressorAudioProcessorEdito
 //==============================================================================
 void MultiBandCompressorAudioProcessorEditor::paint (juce::Graphics& g)
 {
-    Image background = ImageCache::getFromMemory(BinaryData::background_png, BinaryData::background_pngSize);
-    g.drawImageAt(background, 0, 0);
+    // The static chrome is rendered once per size or scale, the components draw on top
+    if (staticLayer.isNull())
+        updateStaticLayer();
+
+    g.drawImage(staticLayer, getLocalBounds().toFloat());
+}
+
+void MultiBandCompressorAudioProcessorEditor::setScaleFactor(float newScale)
+{
+    AudioProcessorEditor::setScaleFactor(newScale);
+    staticLayer = Image();
+    repaint();
+}
+
+void MultiBandCompressorAudioProcessorEditor::updateStaticLayer()
+{
+    // Render at the physical pixel size so the cached layer stays sharp
+    const float scale = jmax(1.0f, Component::getApproximateScaleFactorForComponent(this));
+    staticLayer = Image(Image::ARGB, jmax(1, roundToInt(getWidth() * scale)), jmax(1, roundToInt(getHeight() * scale)), true);
+
+    Graphics g(staticLayer);
+    g.addTransform(AffineTransform::scale(scale));
+    paintStaticLayer(g);
+}
+
+void MultiBandCompressorAudioProcessorEditor::paintStaticLayer(Graphics& g)
+{
+    g.drawImageAt(resources->background, 0, 0);
 
     //Draw the semi-transparent rectangle around components
     const Rectangle<float> area(10, 10, 1380, 650);
@@ -48,11 +97,11 @@ void MultiBandCompressorAudioProcessorEditor::paint (juce::Graphics& g)
     // Draw text labels for each component
     // Title
     g.setColour(Colours::white);
-    g.setFont(35.0f);
+    g.setFont(resources->titleFont);
     g.drawFittedText("Multi-Band Compressor", getWidth() / 2 - 125, 10, 250, 75, Justification::centred, 1);
 
     // Others
-    g.setFont(18.0f);
+    g.setFont(resources->labelFont);
 
     // Low Cut Off and High Cut Off Frequencies
     g.drawText("Low Cutoff",  getWidth() / 2 - 390,    110, 200, 50, Justification::centred, false);
@@ -68,6 +117,11 @@ void MultiBandCompressorAudioProcessorEditor::paint (juce::Graphics& g)
     g.drawText("Release",    715,   getHeight() / 2 - 110, 200, 50, Justification::centred, false);
     g.drawText("Gain",       890,   getHeight() / 2 - 110, 200, 50, Justification::centred, false);
 
+    // Morph between the A/B slots
+    g.setFont(resources->smallFont);
+    g.drawText("Morph A/B", 230, 56, 50, 16, Justification::centredLeft, false);
+    g.setFont(resources->labelFont);
+
     // Knee Width and Overall Gain
     g.drawText("Knee Width",    getWidth() - 300, getHeight() / 2 + 140,     200, 50, Justification::centred, false);
     g.drawText("Overall Gain",  getWidth() - 300, getHeight() / 2 + 240,     200, 50, Justification::centred, false);
@@ -76,6 +130,9 @@ void MultiBandCompressorAudioProcessorEditor::paint (juce::Graphics& g)
 
 void MultiBandCompressorAudioProcessorEditor::resized()
 {
+    // Static chrome is re-rendered lazily at the new size
+    staticLayer = Image();
+
     // Cutoff Frequency Sliders
     sliderLowCutoff.setBounds   (getWidth() / 2 - 250,  40, 220, 220);
     sliderHighCutoff.setBounds  (getWidth() / 2 + 20,   40, 220, 220);
@@ -108,158 +165,332 @@ void MultiBandCompressorAudioProcessorEditor::resized()
     sliderHighRelease.setBounds     (760, getHeight() / 2 + 185, 110, 110);
     sliderHighGain.setBounds        (940, getHeight() / 2 + 185, 110, 110);
 
+    // Spectrum Analyser
+    spectrumDisplay.setBounds       (20, 75, 330, 185);
+    responseDisplay.setBounds       (getWidth() - 350, 75, 330, 185);
+
+    // Factory Presets
+    presetSelector.setBounds            (20, 30, 200, 24);
+
+    // A/B Comparison
+    slotAButton.setBounds               (230, 30, 30, 24);
+    slotBButton.setBounds               (262, 30, 30, 24);
+    copySlotButton.setBounds            (300, 30, 80, 24);
+    sliderMorph.setBounds               (280, 56, 212, 16);
+
+    // Undo and Redo
+    undoButton.setBounds                (390, 30, 50, 24);
+    redoButton.setBounds                (442, 30, 50, 24);
+
+    // CPU Load
+    loadLabel.setBounds                 (getWidth() - 350, 30, 200, 24);
+    overloadProtectionButton.setBounds  (getWidth() - 150, 30, 130, 24);
+
+    // Surround Linking
+    for (int role = 0; role < ChannelGroups::numLinkableRoles; role++)
+        linkButtons[role].setBounds     (getWidth() - 350 + 110 * role, 56, 105, 18);
+
+   #if MBC_ENABLE_PROFILING
+    profilerLabel.setBounds         (20, getHeight() - 30, getWidth() - 40, 18);
+   #endif
+
+    // Band Meters
+    lowMeter.setBounds              (1058, getHeight() / 2 - 65,  40, 110);
+    midMeter.setBounds              (1058, getHeight() / 2 + 60,  40, 110);
+    highMeter.setBounds             (1058, getHeight() / 2 + 185, 40, 110);
+
     // Knee Width and Overall Gain
     sliderKneeWidth.setBounds       (getWidth() - 295,  getHeight() / 2 - 40,   185, 185);
     sliderOverallGain.setBounds     (getWidth() - 350,  getHeight() / 2 + 200,   300, 50);
 }
 
+bool MultiBandCompressorAudioProcessorEditor::keyPressed(const KeyPress& key)
+{
+    // Ctrl/Cmd+Z to undo, Ctrl/Cmd+Shift+Z or Ctrl/Cmd+Y to redo
+    if (key == KeyPress('z', ModifierKeys::commandModifier, 0))
+    {
+        audioProcessor.undo();
+        return true;
+    }
+
+    if (key == KeyPress('z', ModifierKeys::commandModifier | ModifierKeys::shiftModifier, 0)
+     || key == KeyPress('y', ModifierKeys::commandModifier, 0))
+    {
+        audioProcessor.redo();
+        return true;
+    }
+
+    return false;
+}
+
 void MultiBandCompressorAudioProcessorEditor::sliderValueChanged(Slider* sliderMoved)
 {}
 
-void MultiBandCompressorAudioProcessorEditor::buttonClicked(Button* buttonThatWasClicked)
+void MultiBandCompressorAudioProcessorEditor::parameterChanged(const String& parameterID, float newValue)
 {
-    if (buttonThatWasClicked == buttonLowCompressorState)
-        audioProcessor.setLowCompressorState((*buttonLowCompressorState).getToggleState());
-    else if (buttonThatWasClicked == buttonMidCompressorState)
-        audioProcessor.setMidCompressorState((*buttonMidCompressorState).getToggleState());
-    else if (buttonThatWasClicked == buttonHighCompressorState)
-        audioProcessor.setHighCompressorState((*buttonHighCompressorState).getToggleState());
+    // May arrive on the audio thread: only flag it, the next vblank does the work
+    parametersChanged = true;
 }
 
-void MultiBandCompressorAudioProcessorEditor::timerCallback()
+void MultiBandCompressorAudioProcessorEditor::changeListenerCallback(ChangeBroadcaster* source)
 {
-    sliderOverallGain.setValue  (audioProcessor.getOverallGain());
-    sliderKneeWidth.setValue    (audioProcessor.getKneeWidth());
-
-    sliderLowCutoff.setValue    (audioProcessor.getLowCutoff());
-    sliderHighCutoff.setValue   (audioProcessor.getHighCutoff());
-
-    sliderLowGain.setValue      (audioProcessor.getLowGain());
-    sliderLowThreshold.setValue (audioProcessor.getLowThreshold());
-    sliderLowRatio.setValue     (audioProcessor.getLowRatio());
-    sliderLowAttack.setValue    (audioProcessor.getLowAttack());
-    sliderLowRelease.setValue   (audioProcessor.getLowRelease());
-
-    sliderMidGain.setValue      (audioProcessor.getMidGain());
-    sliderMidThreshold.setValue (audioProcessor.getMidThreshold());
-    sliderMidRatio.setValue     (audioProcessor.getMidRatio());
-    sliderMidAttack.setValue    (audioProcessor.getMidAttack());
-    sliderMidRelease.setValue   (audioProcessor.getMidRelease());
-
-    sliderHighGain.setValue     (audioProcessor.getHighGain());
-    sliderHighThreshold.setValue(audioProcessor.getHighThreshold());
-    sliderHighRatio.setValue    (audioProcessor.getHighRatio());
-    sliderHighAttack.setValue   (audioProcessor.getHighAttack());
-    sliderHighRelease.setValue  (audioProcessor.getHighRelease());
-
-    (*buttonLowCompressorState).setToggleState  (audioProcessor.getLowCompressorState(), dontSendNotification);
-    (*buttonMidCompressorState).setToggleState  (audioProcessor.getMidCompressorState(), dontSendNotification);
-    (*buttonHighCompressorState).setToggleState (audioProcessor.getHighCompressorState(), dontSendNotification);
-    
+    // Undo and Redo are available only when there is something to undo or redo
+    undoButton.setEnabled(audioProcessor.undoManager.canUndo());
+    redoButton.setEnabled(audioProcessor.undoManager.canRedo());
+}
+
+void MultiBandCompressorAudioProcessorEditor::vBlankCallback()
+{
+    // Sliders and buttons follow their attachments, the displays follow these listeners
+    if (! listeningToParameters)
+    {
+        for (auto* parameter : audioProcessor.getParameters())
+            if (auto* parameterWithID = dynamic_cast<AudioProcessorParameterWithID*>(parameter))
+                audioProcessor.parameters.addParameterListener(parameterWithID->paramID, this);
+
+        listeningToParameters = true;
+    }
+
+    // Meters repaint only their own area, and only when their level moved
+    lowMeter.update();
+    midMeter.update();
+    highMeter.update();
+
+    // Parameter changes since the last frame are coalesced into one update
+    const double sampleRate = audioProcessor.getSampleRate();
+    if (parametersChanged.exchange(false) || sampleRate != displayedSampleRate)
+    {
+        displayedSampleRate = sampleRate;
+        responseDisplay.update(audioProcessor.getParameterSnapshot(), sampleRate);
+
+        // Follow program changes made by the host, presets always write the parameters
+        if (presetSelector.getSelectedItemIndex() != audioProcessor.getCurrentProgram())
+            presetSelector.setSelectedItemIndex(audioProcessor.getCurrentProgram(), dontSendNotification);
+
+        // A/B buttons follow the "abSlot" parameter, however it was switched, the audio thread swaps on its next grid line
+        const int slot = slotParameter->load() >= 0.5f ? 1 : 0;
+        if (slot != displayedSlot)
+        {
+            displayedSlot = slot;
+            slotAButton.setToggleState(slot == 0, dontSendNotification);
+            slotBButton.setToggleState(slot == 1, dontSendNotification);
+            copySlotButton.setButtonText(slot == 0 ? "Copy to B" : "Copy to A");
+        }
+    }
+
+    // The spectrum only redraws when the analyser has a new frame or the cutoffs moved
+    spectrumDisplay.update(audioProcessor.getLowCutoff(), audioProcessor.getHighCutoff());
+
+    // CPU load is refreshed four times a second, showing the peak since the last refresh
+    const uint32 now = Time::getMillisecondCounter();
+    if (now - lastLoadUpdate >= 250)
+    {
+        lastLoadUpdate = now;
+        auto& loadMonitor = audioProcessor.getLoadMonitor();
+        loadLabel.setText("CPU " + String(loadMonitor.getAverageLoad() * 100.0f, 1) + "%  peak "
+                          + String(loadMonitor.collectPeakLoad() * 100.0f, 1) + "%"
+                          + (audioProcessor.isFastMathActive() ? "  (fast math)" : ""), dontSendNotification);
+        loadLabel.setColour(Label::textColourId, loadMonitor.getOverloadCount() > 0 ? Colours::orange : Colours::lightgrey);
+
+        // The layout or a restored state may have changed the linking
+        updateLinkButtons();
+    }
+
+   #if MBC_ENABLE_PROFILING
+    // Stage timings are refreshed twice a second
+    if (now - lastProfilerUpdate >= 500)
+    {
+        lastProfilerUpdate = now;
+        profilerLabel.setText(audioProcessor.getProfiler().getReport().replace("\n", "   "), dontSendNotification);
+    }
+   #endif
+}
+
+void MultiBandCompressorAudioProcessorEditor::updateLinkButtons()
+{
+    // A single channel has nothing to link
+    const bool multichannel = audioProcessor.getTotalNumInputChannels() > 1;
+
+    for (int role = 0; role < ChannelGroups::numLinkableRoles; role++)
+    {
+        const auto groupRole = (ChannelGroups::Role) role;
+        linkButtons[role].setVisible(multichannel && audioProcessor.hasChannelRole(groupRole));
+        linkButtons[role].setToggleState(audioProcessor.getChannelLinking(groupRole), dontSendNotification);
+    }
 }
 
 void MultiBandCompressorAudioProcessorEditor::buildElements()
 {
+    // The attachments take the ranges from the parameters, so the sliders set none of their own
     // Knee Width and Overall Gain
     kneeWidthVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "kneeWidth", sliderKneeWidth);
     sliderKneeWidth.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderKneeWidth.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderKneeWidth.setRange(5.0f, 10.0f); addAndMakeVisible(&sliderKneeWidth);
+    addAndMakeVisible(&sliderKneeWidth);
 
     overallGainVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "overallGain", sliderOverallGain);
     sliderOverallGain.setSliderStyle(Slider::SliderStyle::LinearHorizontal);
     sliderOverallGain.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderOverallGain.setRange(0.0f, 4.0f); addAndMakeVisible(&sliderOverallGain);
+    addAndMakeVisible(&sliderOverallGain);
 
     // Low Band Knobs
     lowThresholdVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "lowThresh", sliderLowThreshold);
     sliderLowThreshold.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderLowThreshold.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderLowThreshold.setRange(-80.0f, 0.0f); addAndMakeVisible(&sliderLowThreshold);
+    addAndMakeVisible(&sliderLowThreshold);
 
     lowRatioVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "lowRatio", sliderLowRatio);
     sliderLowRatio.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderLowRatio.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderLowRatio.setRange(1.0f, 10.0f); addAndMakeVisible(&sliderLowRatio);
+    addAndMakeVisible(&sliderLowRatio);
 
     lowAttackVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "lowAttack", sliderLowAttack);
     sliderLowAttack.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderLowAttack.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderLowAttack.setRange(5.0f, 100.0f); addAndMakeVisible(&sliderLowAttack);
+    addAndMakeVisible(&sliderLowAttack);
 
     lowReleaseVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "lowRelease", sliderLowRelease);
     sliderLowRelease.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderLowRelease.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderLowRelease.setRange(5.0f, 100.0f); addAndMakeVisible(&sliderLowRelease);
+    addAndMakeVisible(&sliderLowRelease);
 
     lowGainVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "lowGain", sliderLowGain);
     sliderLowGain.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderLowGain.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderLowGain.setRange(0.0f, 4.0f); addAndMakeVisible(&sliderLowGain);
+    addAndMakeVisible(&sliderLowGain);
 
     // Mid Band Knobs
     midThresholdVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "midThresh", sliderMidThreshold);
     sliderMidThreshold.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderMidThreshold.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderMidThreshold.setRange(-80.0f, 0.0f); addAndMakeVisible(&sliderMidThreshold);
+    addAndMakeVisible(&sliderMidThreshold);
 
     midRatioVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "midRatio", sliderMidRatio);
     sliderMidRatio.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderMidRatio.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderMidRatio.setRange(1.0f, 10.0f); addAndMakeVisible(&sliderMidRatio);
+    addAndMakeVisible(&sliderMidRatio);
 
     midAttackVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "midAttack", sliderMidAttack);
     sliderMidAttack.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderMidAttack.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderMidAttack.setRange(5.0f, 100.0f); addAndMakeVisible(&sliderMidAttack);
+    addAndMakeVisible(&sliderMidAttack);
 
     midReleaseVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "midRelease", sliderMidRelease);
     sliderMidRelease.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderMidRelease.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderMidRelease.setRange(5.0f, 100.0f); addAndMakeVisible(&sliderMidRelease);
+    addAndMakeVisible(&sliderMidRelease);
 
     midGainVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "midGain", sliderMidGain);
     sliderMidGain.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderMidGain.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderMidGain.setRange(0.0f, 4.0f); addAndMakeVisible(&sliderMidGain);
+    addAndMakeVisible(&sliderMidGain);
 
     // High Band Knobs
     highThresholdVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "highThresh", sliderHighThreshold);
     sliderHighThreshold.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderHighThreshold.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderHighThreshold.setRange(-80.0f, 0.0f); addAndMakeVisible(&sliderHighThreshold);
+    addAndMakeVisible(&sliderHighThreshold);
 
     highRatioVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "highRatio", sliderHighRatio);
     sliderHighRatio.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderHighRatio.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderHighRatio.setRange(1.0f, 10.0f); addAndMakeVisible(&sliderHighRatio);
+    addAndMakeVisible(&sliderHighRatio);
 
     highAttackVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "highAttack", sliderHighAttack);
     sliderHighAttack.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderHighAttack.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderHighAttack.setRange(5.0f, 100.0f); addAndMakeVisible(&sliderHighAttack);
+    addAndMakeVisible(&sliderHighAttack);
 
     highReleaseVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "highRelease", sliderHighRelease);
     sliderHighRelease.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderHighRelease.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderHighRelease.setRange(5.0f, 100.0f); addAndMakeVisible(&sliderHighRelease);
+    addAndMakeVisible(&sliderHighRelease);
 
     highGainVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "highGain", sliderHighGain);
     sliderHighGain.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderHighGain.setTextBoxStyle(Slider::TextBoxBelow, false, 70, 20);
-    sliderHighGain.setRange(0.0f, 4.0f); addAndMakeVisible(&sliderHighGain);
+    addAndMakeVisible(&sliderHighGain);
 
     // Low Cutoff Frequency Slider
     lowCutOffVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "lowCutOff", sliderLowCutoff);
     sliderLowCutoff.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderLowCutoff.setTextBoxStyle(Slider::TextBoxRight, false, 70, 20);
-    sliderLowCutoff.setRange(150.0f, 600.0f); sliderLowCutoff.setSkewFactor(2); addAndMakeVisible(&sliderLowCutoff);
+    sliderLowCutoff.setSkewFactor(2); addAndMakeVisible(&sliderLowCutoff);
 
     // High Cutoff Frequency Slider
     highCutOffVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "highCutOff", sliderHighCutoff);
     sliderHighCutoff.setSliderStyle(Slider::SliderStyle::Rotary);
     sliderHighCutoff.setTextBoxStyle(Slider::TextBoxLeft, false, 70, 20);
-    sliderHighCutoff.setRange(1000.0f, 4000.0f); sliderHighCutoff.setSkewFactor(2); addAndMakeVisible(&sliderHighCutoff);
+    sliderHighCutoff.setSkewFactor(2); addAndMakeVisible(&sliderHighCutoff);
+
+    // Morph Slider
+    morphVal = make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "morph", sliderMorph);
+    sliderMorph.setSliderStyle(Slider::SliderStyle::LinearHorizontal);
+    sliderMorph.setTextBoxStyle(Slider::NoTextBox, false, 0, 0);
+    addAndMakeVisible(&sliderMorph);
+
+    // Band Meters
+    addAndMakeVisible(&lowMeter);
+    addAndMakeVisible(&midMeter);
+    addAndMakeVisible(&highMeter);
+
+    // Spectrum Analyser
+    addAndMakeVisible(&spectrumDisplay);
+    addAndMakeVisible(&responseDisplay);
+
+    // Factory Presets, switched with a crossfade by the processor
+    for (int i = 0; i < audioProcessor.getNumPrograms(); i++)
+        presetSelector.addItem(audioProcessor.getProgramName(i), i + 1);
+    presetSelector.setSelectedItemIndex(audioProcessor.getCurrentProgram(), dontSendNotification);
+    presetSelector.onChange = [this] { audioProcessor.setCurrentProgram(presetSelector.getSelectedItemIndex()); };
+    addAndMakeVisible(&presetSelector);
+
+    // A/B Comparison
+    for (auto* button : { &slotAButton, &slotBButton })
+    {
+        button->setColour(TextButton::buttonOnColourId, Colours::lightblue);
+        button->setColour(TextButton::textColourOnId, Colours::black);
+        addAndMakeVisible(button);
+    }
+    slotAButton.onClick = [this] { audioProcessor.selectSlot(0); };
+    slotBButton.onClick = [this] { audioProcessor.selectSlot(1); };
+    copySlotButton.onClick = [this] { audioProcessor.copyToOtherSlot(); };
+    addAndMakeVisible(&copySlotButton);
+
+    // Undo and Redo
+    undoButton.onClick = [this] { audioProcessor.undo(); };
+    redoButton.onClick = [this] { audioProcessor.redo(); };
+    addAndMakeVisible(&undoButton);
+    addAndMakeVisible(&redoButton);
+
+    // CPU Load and Overload Protection
+    loadLabel.setFont(resources->smallFont);
+    loadLabel.setColour(Label::textColourId, Colours::lightgrey);
+    addAndMakeVisible(&loadLabel);
+
+    overloadProtectionButton.setColour(ToggleButton::textColourId, Colours::white);
+    overloadProtectionButton.setToggleState(audioProcessor.getOverloadProtection(), dontSendNotification);
+    overloadProtectionButton.onClick = [this] { audioProcessor.setOverloadProtection(overloadProtectionButton.getToggleState()); };
+    addAndMakeVisible(&overloadProtectionButton);
+
+    // Surround Linking, shown for the groups the layout has
+    const char* linkNames[] = { "Link front", "Link surround", "Link height" };
+    for (int role = 0; role < ChannelGroups::numLinkableRoles; role++)
+    {
+        auto& button = linkButtons[role];
+        button.setButtonText(linkNames[role]);
+        button.setColour(ToggleButton::textColourId, Colours::white);
+        button.onClick = [this, role] { audioProcessor.setChannelLinking((ChannelGroups::Role) role, linkButtons[role].getToggleState()); };
+        addChildComponent(&button);
+    }
+    updateLinkButtons();
+
+   #if MBC_ENABLE_PROFILING
+    // Stage Timing
+    profilerLabel.setFont(Font(12.0f));
+    profilerLabel.setColour(Label::textColourId, Colours::lightgrey);
+    addAndMakeVisible(&profilerLabel);
+   #endif
 
     // Compressor State Buttons
     addAndMakeVisible(buttonLowCompressorState = new TextButton("Low Compressor"));
@@ -267,23 +498,27 @@ void MultiBandCompressorAudioProcessorEditor::buildElements()
     (*buttonLowCompressorState).setColour(TextButton::buttonOnColourId, Colours::lightblue);
     (*buttonLowCompressorState).setColour(TextButton::textColourOnId, Colours::black);
     (*buttonLowCompressorState).setColour(TextButton::textColourOffId, Colours::white);
-    (*buttonLowCompressorState).addListener(this);
 
     addAndMakeVisible(buttonMidCompressorState = new TextButton("Mid Compressor"));
     (*buttonMidCompressorState).setButtonText(TRANS("Mid"));
     (*buttonMidCompressorState).setColour(TextButton::buttonOnColourId, Colours::lightblue);
     (*buttonMidCompressorState).setColour(TextButton::textColourOnId, Colours::black);
     (*buttonMidCompressorState).setColour(TextButton::textColourOffId, Colours::white);
-    (*buttonMidCompressorState).addListener(this);
 
     addAndMakeVisible(buttonHighCompressorState = new TextButton("High Compressor"));
     (*buttonHighCompressorState).setButtonText(TRANS("High"));
     (*buttonHighCompressorState).setColour(TextButton::buttonOnColourId, Colours::lightblue);
     (*buttonHighCompressorState).setColour(TextButton::textColourOnId, Colours::black);
     (*buttonHighCompressorState).setColour(TextButton::textColourOffId, Colours::white);
-    (*buttonHighCompressorState).addListener(this);
     
     (*buttonLowCompressorState).setClickingTogglesState(true);
     (*buttonMidCompressorState).setClickingTogglesState(true);
     (*buttonHighCompressorState).setClickingTogglesState(true);
+
+    // Compressor States follow the host-automatable parameters
+    lowCompressorStateVal = make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.parameters, "lowEnabled", *buttonLowCompressorState);
+    midCompressorStateVal = make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.parameters, "midEnabled", *buttonMidCompressorState);
+    highCompressorStateVal = make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.parameters, "highEnabled", *buttonHighCompressorState);
+
+    // Undo: the attachments' gestures start one transaction per drag or click, before the first value (see the processor)
 }
\ No newline at end of file
@@ -10,6 +10,10 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "LevelMeter.h"
+#include "SpectrumDisplay.h"
+#include "ResponseDisplay.h"
+#include "SharedResources.h"
 
 using namespace std;
 using namespace juce;
@@ -17,7 +21,8 @@ using namespace juce;
 //==============================================================================
 /**
 */
-class MultiBandCompressorAudioProcessorEditor  : public juce::AudioProcessorEditor, public Timer, public Slider::Listener, public Button::Listener
+class MultiBandCompressorAudioProcessorEditor  : public juce::AudioProcessorEditor, public Slider::Listener, public AudioProcessorValueTreeState::Listener,
+                                                 private ChangeListener
 {
 public:
     MultiBandCompressorAudioProcessorEditor (MultiBandCompressorAudioProcessor&);
@@ -27,9 +32,11 @@ public:
 
     void paint(Graphics&) override;
     void resized() override;
+    void setScaleFactor(float newScale) override;
+    bool keyPressed(const KeyPress& key) override;
     void sliderValueChanged(Slider* sliderMoved) override;
-    void buttonClicked(Button* buttonClicked) override;
-    void timerCallback() override;
+    void parameterChanged(const String& parameterID, float newValue) override;
+    void vBlankCallback();
     void buildElements();
 
     // Crossover Cutoff Values
@@ -61,10 +68,26 @@ public:
     unique_ptr<AudioProcessorValueTreeState::SliderAttachment> kneeWidthVal;            // Attachment for Knee Width Value
     unique_ptr<AudioProcessorValueTreeState::SliderAttachment> overallGainVal;          // Attachment for Overall Gain Value
 
+    // Morph between the A/B slots
+    unique_ptr<AudioProcessorValueTreeState::SliderAttachment> morphVal;                // Attachment for Morph Value
+
+    // Compressor States
+    unique_ptr<AudioProcessorValueTreeState::ButtonAttachment> lowCompressorStateVal;   // Attachment for Low Compressor State
+    unique_ptr<AudioProcessorValueTreeState::ButtonAttachment> midCompressorStateVal;   // Attachment for Mid Compressor State
+    unique_ptr<AudioProcessorValueTreeState::ButtonAttachment> highCompressorStateVal;  // Attachment for High Compressor State
+
 private:
     // Audio Processor Object
     MultiBandCompressorAudioProcessor& audioProcessor;
 
+    // Artwork and fonts, decoded once for every editor in the process
+    SharedResourcePointer<EditorResources> resources;
+
+    // Background, frame and labels, rendered once per size or scale change
+    Image staticLayer;
+    void updateStaticLayer();
+    void paintStaticLayer(Graphics& g);
+
     // Crossover Cutoff Sliders
     Slider sliderLowCutoff;
     Slider sliderHighCutoff;
@@ -94,6 +117,55 @@ private:
     Slider sliderKneeWidth;
     Slider sliderOverallGain;
 
+    // Band Meters
+    LevelMeter lowMeter;
+    LevelMeter midMeter;
+    LevelMeter highMeter;
+
+    // Spectrum Analyser with the crossover frequencies
+    SpectrumDisplay spectrumDisplay;
+
+    // Compression curves and crossover response
+    ResponseDisplay responseDisplay;
+
+    // Factory Presets
+    ComboBox presetSelector;
+
+    // Undo and Redo
+    TextButton undoButton { "Undo" };
+    TextButton redoButton { "Redo" };
+
+    // A/B Comparison
+    TextButton slotAButton { "A" };
+    TextButton slotBButton { "B" };
+    TextButton copySlotButton { "Copy to B" };
+    Slider sliderMorph;
+    atomic<float>* slotParameter = nullptr;
+    int displayedSlot = -1;
+
+    // CPU Load and Overload Protection
+    Label loadLabel;
+    ToggleButton overloadProtectionButton { "Degrade on overload" };
+    uint32 lastLoadUpdate = 0;
+
+    // Surround Linking, one toggle per channel group of the bus layout
+    ToggleButton linkButtons[ChannelGroups::numLinkableRoles];
+    void updateLinkButtons();
+
+   #if MBC_ENABLE_PROFILING
+    // Stage Timing
+    Label profilerLabel;
+    uint32 lastProfilerUpdate = 0;
+   #endif
+
+    // Display updates, at most once per frame and only for what changed.
+    // The parameter listeners are registered on the first frame, not while the editor is built.
+    atomic<bool> parametersChanged { true };
+    bool listeningToParameters = false;
+    double displayedSampleRate = 0;
+    void changeListenerCallback(ChangeBroadcaster* source) override;
+    VBlankAttachment vBlankAttachment { this, [this] { vBlankCallback(); } };
+
     // Buttons to Switch the Compressor states to ON/OFF
     ScopedPointer<TextButton> buttonLowCompressorState;
     ScopedPointer<TextButton> buttonMidCompressorState;
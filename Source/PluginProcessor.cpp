@@ -22,17 +22,32 @@ MultiBandCompressorAudioProcessor::MultiBandCompressorAudioProcessor()
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
-                       ), parameters(*this, nullptr, "Parameter", createParameters())
+                       ), parameters(*this, &undoManager, "Parameter", createParameters())
 #endif
 {
-    // Default Compressor States
-    pLowCompressorState = 1;
-    pMidCompressorState = 1;
-    pHighCompressorState = 1;
+    // Resolve the raw parameter pointers once
+    parameterHandles.resolve(parameters);
+    slotParameter = parameters.getRawParameterValue("abSlot");
+    morphParameter = parameters.getRawParameterValue("morph");
+
+    // Both engines publish to the same meters and profiler
+    for (auto& engine : engines)
+    {
+        engine.setMeters(lowMeter, midMeter, highMeter);
+       #if MBC_ENABLE_PROFILING
+        engine.setProfiler(profiler);
+       #endif
+    }
+
+    // Gestures start the undo transactions
+    for (auto* parameter : getParameters())
+        parameter->addListener(this);
 }
 
 MultiBandCompressorAudioProcessor::~MultiBandCompressorAudioProcessor()
 {
+    for (auto* parameter : getParameters())
+        parameter->removeListener(this);
 }
 
 //==============================================================================
@@ -75,22 +90,47 @@ double MultiBandCompressorAudioProcessor::getTailLengthSeconds() const
 
 int MultiBandCompressorAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return numFactoryPresets;
 }
 
 int MultiBandCompressorAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void MultiBandCompressorAudioProcessor::setCurrentProgram (int index)
 {
+    if (! isPositiveAndBelow(index, numFactoryPresets))
+        return;
+
+    currentProgram = index;
+    const ParameterSnapshot& preset = factoryPresets[index].values;
+
+    // A host may load a program from the audio thread, only loads on the message thread are undoable
+    const bool undoable = MessageManager::existsAndIsCurrentThread();
+    if (undoable)
+        beginUndoTransaction("Load " + String(factoryPresets[index].name));
+
+    // While playing, reset the idle engine to the preset and let the audio thread crossfade to it. prepareToPlay
+    // prepared both engines, so this neither allocates nor reads the processing setup.
+    // Before playback, or while the previous switch is still fading, the values are only written.
+    int expectedState = engineIdle;
+    const bool crossfade = enginesPrepared.load() && engineState.compare_exchange_strong(expectedState, enginePreparing);
+
+    if (crossfade)
+        engines[1 - activeEngine.load()].reset(preset);
+
+    writeParameters(preset);
+    if (undoable)
+        endUndoTransaction();
+
+    if (crossfade)
+        engineState = engineReady;
 }
 
 const juce::String MultiBandCompressorAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return isPositiveAndBelow(index, numFactoryPresets) ? String(factoryPresets[index].name) : String();
 }
 
 void MultiBandCompressorAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -102,49 +142,74 @@ void MultiBandCompressorAudioProcessor::prepareToPlay (double sampleRate, int sa
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+    // A preset loaded while the engines are being prepared is only written, it never resets them
+    enginesPrepared = false;
     numChannels = getTotalNumInputChannels();
+    maxSubBlockSize = jmax(1, samplesPerBlock);
+    // The engines only run the input channels, a mono input is never processed as stereo
+    numBufferChannels = jmax(1, getTotalNumInputChannels());
+
+    // Detector groups of the input layout, built on the first block
+    const AudioChannelSet inputLayout = getChannelLayoutOfBus(true, 0);
+    for (int channel = 0; channel < ChannelGroups::maxChannels; channel++)
+        channelRoles[channel] = ChannelGroups::getRole(inputLayout.getTypeOfChannel(channel));
+    appliedChannelLinking = -1;
+    preparedSampleRate = sampleRate;
 
-    // Calculate Filter Coefficients
-    //==============================
-    // First Left Channel Filters
-    lowBandFilterL1.setCoefficients(coefficients.makeLowPass(sampleRate, getLowCutoff()));
-    lowMidBandFilterL1.setCoefficients(coefficients.makeHighPass(sampleRate, getLowCutoff()));
-    highMidBandFilterL1.setCoefficients(coefficients.makeLowPass(sampleRate, getHighCutoff()));
-    highBandFilterL1.setCoefficients(coefficients.makeHighPass(sampleRate, getHighCutoff()));
-
-    // First Right Channel Filters
-    lowBandFilterR1.setCoefficients(coefficients.makeLowPass(sampleRate, getLowCutoff()));
-    lowMidBandFilterR1.setCoefficients(coefficients.makeHighPass(sampleRate, getLowCutoff()));
-    highMidBandFilterR1.setCoefficients(coefficients.makeLowPass(sampleRate, getHighCutoff()));
-    highBandFilterR1.setCoefficients(coefficients.makeHighPass(sampleRate, getHighCutoff()));
-
-    // Second Left Channel Filters
-    lowBandFilterL2.setCoefficients(coefficients.makeLowPass(sampleRate, getLowCutoff()));
-    lowMidBandFilterL2.setCoefficients(coefficients.makeHighPass(sampleRate, getLowCutoff()));
-    highMidBandFilterL2.setCoefficients(coefficients.makeLowPass(sampleRate, getHighCutoff()));
-    highBandFilterL2.setCoefficients(coefficients.makeHighPass(sampleRate, getHighCutoff()));
-
-    // Second Right Channel Filters
-    lowBandFilterR2.setCoefficients(coefficients.makeLowPass(sampleRate, getLowCutoff()));
-    lowMidBandFilterR2.setCoefficients(coefficients.makeHighPass(sampleRate, getLowCutoff()));
-    highMidBandFilterR2.setCoefficients(coefficients.makeLowPass(sampleRate, getHighCutoff()));
-    highBandFilterR2.setCoefficients(coefficients.makeHighPass(sampleRate, getHighCutoff()));
-
-    // Prepare the Compressors
-    lowCompressor.prepareToPlay(sampleRate, samplesPerBlock, getTotalNumInputChannels());
-    midCompressor.prepareToPlay(sampleRate, samplesPerBlock, getTotalNumInputChannels());
-    highCompressor.prepareToPlay(sampleRate, samplesPerBlock, getTotalNumInputChannels());
-
-    // Initialise the Compressor Parameters
-    lowCompressor.setParameters(getLowRatio(), getLowThreshold(), getLowAttack(), getLowRelease(), getLowGain(), getKneeWidth());
-    midCompressor.setParameters(getMidRatio(), getMidThreshold(), getMidAttack(), getMidRelease(), getMidGain(), getKneeWidth());
-    highCompressor.setParameters(getHighRatio(), getHighThreshold(), getHighAttack(), getHighRelease(), getHighGain(), getKneeWidth());
+    // Take one coherent set of parameter values
+    const ParameterSnapshot snapshot = parameterHandles.load();
+
+    // Prepare both engines, so a preset switch never allocates
+    for (auto& engine : engines)
+        engine.prepare(sampleRate, maxSubBlockSize, numBufferChannels, snapshot);
+
+    // A/B Slots start from the current values, their coefficients follow the sample rate
+    {
+        const SpinLock::ScopedLockType lock(slotLock);
+        if (! slotsInitialised)
+        {
+            for (auto& values : slotValues)
+                values = snapshot;
+            slotsInitialised = true;
+        }
+
+        updateSlotCoefficients();
+    }
+
+    // The morph source coefficients are designed again at the new sample rate
+    morphSourceLowCutOff = morphSourceHighCutOff = -1;
+    morphApplied = false;
+
+    // Processing Grid, counted from the start of playback, with the prepared values as the last ones read
+    gridPosition = 0;
+    readValues = snapshot;
+    readSequence = parameterWriteSequence.load();
+    appliedMorph = -1;
+
+    // Preset Crossfade
+    fadeBuffer.setSize(numBufferChannels, maxSubBlockSize);
+    warmUpSamples = roundToInt(sampleRate * presetWarmUpTime);
+    fadeSamples = jmax(1, roundToInt(sampleRate * presetFadeTime));
+    engineState = engineIdle;
+    enginesPrepared = true;
+
+    // Spectrum Analyser
+    analyser.prepare(sampleRate);
+
+    // CPU Load against the new block budget
+    loadMonitor.prepare(sampleRate);
+
+    // Overload events are logged and automated A/B switches reach the parameters from the message thread.
+    // Nothing reaches the timer before playback, so instances that never play never start it.
+    if (! isTimerRunning())
+        startTimerHz(10);
 }
 
 void MultiBandCompressorAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    enginesPrepared = false;
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -154,17 +219,19 @@ bool MultiBandCompressorAudioProcessor::isBusesLayoutSupported (const BusesLayou
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Mono, stereo, mono in with stereo out, and 5.1, 7.1 and 7.1.4 surround.
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    const auto input = layouts.getMainInputChannelSet();
+    const auto output = layouts.getMainOutputChannelSet();
+
+    if (output != juce::AudioChannelSet::mono() && output != juce::AudioChannelSet::stereo()
+     && output != juce::AudioChannelSet::create5point1() && output != juce::AudioChannelSet::create7point1()
+     && output != juce::AudioChannelSet::create7point1point4())
         return false;
 
-    // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    if (input != output && ! (input == juce::AudioChannelSet::mono() && output == juce::AudioChannelSet::stereo()))
         return false;
    #endif
 
@@ -180,104 +247,439 @@ void MultiBandCompressorAudioProcessor::processBlock(AudioSampleBuffer& buffer,
     const int totalNumInputChannels = getTotalNumInputChannels();
     const int totalNumOutputChannels = getTotalNumOutputChannels();
     const int numSamples = buffer.getNumSamples();
+    const LoadMonitor::ScopedMeasurement loadMeasurement(loadMonitor, numSamples);
 
-    // Initialise Buffer for Each Band
-    AudioSampleBuffer lowOutput;
-    AudioSampleBuffer midOutput;
-    AudioSampleBuffer highOutput;
-
-    // Set each buffer to an input
-    lowOutput.makeCopyOf(buffer);
-    midOutput.makeCopyOf(buffer);
-    highOutput.makeCopyOf(buffer);
-
-    float sampleRate = getSampleRate();
+    // Degrade to fast math while the recent blocks come close to their budget
+    updateOverloadProtection();
 
     // In case we have more outputs than inputs, this code clears any output channels that didn't contain input data
     for (int i = totalNumInputChannels; i < totalNumOutputChannels; ++i) { buffer.clear(i, 0, buffer.getNumSamples()); }
 
-    //===========================DSP PROCESSING STARTS HERE====================================================//
-
-    // Recalculate the coefficients in case the cutoffs are altered
-    // First Left Channel Filters
-    lowBandFilterL1.setCoefficients(coefficients.makeLowPass(sampleRate, getLowCutoff()));
-    lowMidBandFilterL1.setCoefficients(coefficients.makeHighPass(sampleRate, getLowCutoff()));
-    highMidBandFilterL1.setCoefficients(coefficients.makeLowPass(sampleRate, getHighCutoff()));
-    highBandFilterL1.setCoefficients(coefficients.makeHighPass(sampleRate, getHighCutoff()));
-
-    // First Right Channel Filters
-    lowBandFilterR1.setCoefficients(coefficients.makeLowPass(sampleRate, getLowCutoff()));
-    lowMidBandFilterR1.setCoefficients(coefficients.makeHighPass(sampleRate, getLowCutoff()));
-    highMidBandFilterR1.setCoefficients(coefficients.makeLowPass(sampleRate, getHighCutoff()));
-    highBandFilterR1.setCoefficients(coefficients.makeHighPass(sampleRate, getHighCutoff()));
-
-    // Second Left Channel Filters
-    lowBandFilterL2.setCoefficients(coefficients.makeLowPass(sampleRate, getLowCutoff()));
-    lowMidBandFilterL2.setCoefficients(coefficients.makeHighPass(sampleRate, getLowCutoff()));
-    highMidBandFilterL2.setCoefficients(coefficients.makeLowPass(sampleRate, getHighCutoff()));
-    highBandFilterL2.setCoefficients(coefficients.makeHighPass(sampleRate, getHighCutoff()));
-
-    // Second Right Channel Filters
-    lowBandFilterR2.setCoefficients(coefficients.makeLowPass(sampleRate, getLowCutoff()));
-    lowMidBandFilterR2.setCoefficients(coefficients.makeHighPass(sampleRate, getLowCutoff()));
-    highMidBandFilterR2.setCoefficients(coefficients.makeLowPass(sampleRate, getHighCutoff()));
-    highBandFilterR2.setCoefficients(coefficients.makeHighPass(sampleRate, getHighCutoff()));
-
-    // Apply Filter onto the buffer
-    //==============================
-    // First Low Band Filtering Stage
-    lowBandFilterL1.processSamples(lowOutput.getWritePointer(0), numSamples);
-    lowBandFilterR1.processSamples(lowOutput.getWritePointer(1), numSamples);
-    // Second Low Band Filtering Stage
-    lowBandFilterL2.processSamples(lowOutput.getWritePointer(0), numSamples);
-    lowBandFilterR2.processSamples(lowOutput.getWritePointer(1), numSamples);
-
-    // First Low - Mid Band Filtering Stage
-    lowMidBandFilterL1.processSamples(midOutput.getWritePointer(0), numSamples);
-    lowMidBandFilterR1.processSamples(midOutput.getWritePointer(1), numSamples);
-    // Second Low - Mid Band Filtering Stage
-    lowMidBandFilterL2.processSamples(midOutput.getWritePointer(0), numSamples);
-    lowMidBandFilterR2.processSamples(midOutput.getWritePointer(1), numSamples);
-
-    //First High - Mid Band Filtering Stage
-    highMidBandFilterL1.processSamples(midOutput.getWritePointer(0), numSamples);
-    highMidBandFilterR1.processSamples(midOutput.getWritePointer(1), numSamples);
-    // Second High - Mid Band Filtering Stage
-    highMidBandFilterL2.processSamples(midOutput.getWritePointer(0), numSamples);
-    highMidBandFilterR2.processSamples(midOutput.getWritePointer(1), numSamples);
-
-    // First High Band Filtering Stage
-    highBandFilterL1.processSamples(highOutput.getWritePointer(0), numSamples);
-    highBandFilterR1.processSamples(highOutput.getWritePointer(1), numSamples);
-    // Second High Band Filtering Stage
-    highBandFilterL2.processSamples(highOutput.getWritePointer(0), numSamples);
-    highBandFilterR2.processSamples(highOutput.getWritePointer(1), numSamples);
-
-    // Set the Compressor Parameters
-    lowCompressor.setParameters(getLowRatio(), getLowThreshold(), getLowAttack(), getLowRelease(), getLowGain(), getKneeWidth());
-
-    midCompressor.setParameters(getMidRatio(), getMidThreshold(), getMidAttack(), getMidRelease(), getMidGain(), getKneeWidth());
-    highCompressor.setParameters(getHighRatio(), getHighThreshold(), getHighAttack(), getHighRelease(), getHighGain(), getKneeWidth());
-
-    // Compress Each Band
-    if (getLowCompressorState())
-        lowCompressor.processBlock(lowOutput);
-    if (getMidCompressorState())
-        midCompressor.processBlock(midOutput);
-    if (getHighCompressorState())
-        highCompressor.processBlock(highOutput);
-
-    // Sum Each Band
-    buffer.clear();
-    for (int channel = 0; channel < totalNumInputChannels; channel++)
+    // Feed the analyser before compression
+    analyser.pushInput(buffer, totalNumInputChannels, 0, numSamples);
+
+    // Split the block on the processing grid, which carries on across blocks, and where it outgrows the band buffers.
+    // Everything that changes the output is read on grid lines only, the sub-blocks between them keep the last values.
+    // While nothing waits for a grid line, the block runs in one piece.
+    const int grid = processingGridSize.load();
+    if (grid <= 0 || gridPosition >= grid)
+        gridPosition = 0;
+
+    auto getSubBlockLength = [&] (int startSample, bool changePending)
+    {
+        int length = jmin(numSamples - startSample, maxSubBlockSize);
+        if (grid > 0)
+        {
+            if (changePending)
+                length = jmin(length, grid - gridPosition);
+            gridPosition = (gridPosition + length) % grid;
+        }
+        return length;
+    };
+
+    int subBlockLength = 0;
+    for (int startSample = 0; startSample < numSamples; startSample += subBlockLength)
+    {
+        const bool onGrid = grid > 0 ? gridPosition == 0 : startSample == 0;
+
+        if (onGrid)
+        {
+            // Follow changes to the surround linking
+            updateChannelGroups();
+
+            // A/B switches happen on the grid, never during a preset crossfade
+            const int requestedSlot = *slotParameter >= 0.5f ? 1 : 0;
+            if (requestedSlot != activeSlot.load() && engineState.load() == engineIdle)
+                switchSlot(requestedSlot);
+        }
+
+        // A prepared preset starts its crossfade on the next grid line
+        int state = engineState.load();
+        if (onGrid && state == engineReady)
+        {
+            fadePosition = 0;
+            engineState = state = engineFading;
+        }
+
+        if (state == engineFading)
+        {
+            subBlockLength = getSubBlockLength(startSample, true);
+            processPresetCrossfade(buffer, startSample, subBlockLength, onGrid);
+            continue;
+        }
+
+        // Read every parameter once per grid line, holding the last values while a state or preset is written
+        auto& engine = engines[activeEngine.load()];
+        ParameterSnapshot snapshot = engine.getSnapshot();
+        const bool hold = ! onGrid || state == enginePreparing || ! readParameters(snapshot);
+
+        // Morphing: values and warped cutoffs blended toward the other slot. The other slot's coefficients come ready made,
+        // only the active slot's own are designed here, and only when its cutoffs move (see updateMorphEndpoints)
+        const float morph = morphParameter->load();
+        if (! hold)
+        {
+            morphApplied = false;
+            appliedMorph = morph;
+        }
+
+        if (! hold && morph > 0.0f && updateMorphEndpoints(snapshot))
+        {
+            morphSourceValues = snapshot;
+            morphApplied = true;
+            snapshot = interpolate(snapshot, morphTarget, morph);
+            engine.applySettings(snapshot, Crossover::Coefficients::interpolate(morphSourceCoefficients, morphTargetCoefficients, morph));
+        }
+
+        subBlockLength = getSubBlockLength(startSample, isChangePending());
+        engine.setChannelGroups(channelGroups);
+        engine.setMetering(true);
+        engine.process(buffer, startSample, subBlockLength, totalNumInputChannels, snapshot);
+    }
+
+    // Feed the analyser after compression
+    analyser.pushOutput(buffer, totalNumInputChannels, 0, numSamples);
+
+    // Mono in, stereo out: the processed channel goes to both sides
+    if (totalNumInputChannels == 1)
+        for (int i = 1; i < totalNumOutputChannels; ++i)
+            buffer.copyFrom(i, 0, buffer, 0, 0, numSamples);
+}
+
+void MultiBandCompressorAudioProcessor::processPresetCrossfade(AudioSampleBuffer& buffer, int startSample, int numSamples, bool onGrid)
+{
+    const int totalNumInputChannels = getTotalNumInputChannels();
+    const int fadeChannels = jmin(buffer.getNumChannels(), fadeBuffer.getNumChannels());
+    auto& outgoing = engines[activeEngine.load()];
+    auto& incoming = engines[1 - activeEngine.load()];
+
+    // The incoming engine gets its own copy of the input
+    for (int channel = 0; channel < fadeChannels; channel++)
+        fadeBuffer.copyFrom(channel, 0, buffer, channel, startSample, numSamples);
+
+    // The outgoing engine keeps the previous values, the incoming one follows the parameters
+    outgoing.setChannelGroups(channelGroups);
+    incoming.setChannelGroups(channelGroups);
+
+    // The meters follow the engine that is fading in, so the two never interleave their readings
+    outgoing.setMetering(false);
+    incoming.setMetering(true);
+    outgoing.process(buffer, startSample, numSamples, totalNumInputChannels, outgoing.getSnapshot());
+    ParameterSnapshot incomingSnapshot = incoming.getSnapshot();
+    if (onGrid)
+        readParameters(incomingSnapshot);
+
+    incoming.process(fadeBuffer, 0, numSamples, totalNumInputChannels, incomingSnapshot);
+
+    const float startMix = getPresetMix(fadePosition);
+    fadePosition += numSamples;
+    const float endMix = getPresetMix(fadePosition);
+
+    if (endMix > 0.0f)
+    {
+        for (int channel = 0; channel < totalNumInputChannels; channel++)
+        {
+            buffer.applyGainRamp(channel, startSample, numSamples, 1.0f - startMix, 1.0f - endMix);
+            buffer.addFromWithRamp(channel, startSample, fadeBuffer.getReadPointer(channel), numSamples, startMix, endMix);
+        }
+    }
+
+    // Crossfade done: the incoming engine takes over, it never runs morphed values, so the next grid line blends it again
+    if (fadePosition >= warmUpSamples + fadeSamples)
+    {
+        morphApplied = false;
+        appliedMorph = -1;
+        activeEngine = 1 - activeEngine.load();
+        engineState = engineIdle;
+    }
+}
+
+bool MultiBandCompressorAudioProcessor::readParameters(ParameterSnapshot& snapshot)
+{
+    // Nothing is taken while a whole state or preset is written, or when a write started during the load
+    const uint32 sequence = parameterWriteSequence.load();
+    if (parameterWriters.load() > 0)
+        return false;
+
+    const ParameterSnapshot live = parameterHandles.load();
+    if (parameterWriteSequence.load() != sequence)
+        return false;
+
+    snapshot = live;
+    readValues = live;
+    readSequence = sequence;
+
+    // After an A/B switch, parameters that have not moved since keep the slot's values
+    if (slotSwitchHeld)
+    {
+        snapshot = takeChanged(slotSwitchValues, slotSwitchParameters, live);
+        slotSwitchHeld = ! (snapshot == live);
+    }
+
+    return true;
+}
+
+float MultiBandCompressorAudioProcessor::getPresetMix(int position) const
+{
+    return jlimit(0.0f, 1.0f, (float) (position - warmUpSamples) / (float) fadeSamples);
+}
+
+void MultiBandCompressorAudioProcessor::switchSlot(int slot)
+{
+    const SpinLock::ScopedTryLockType lock(slotLock);
+    if (! lock.isLocked())
+        return;
+
+    // Keep the active slot's own values, never the morph toward the other slot,
+    // then jump to the other one without recomputing anything
+    auto& engine = engines[activeEngine.load()];
+    const int previousSlot = activeSlot.load();
+    slotValues[previousSlot] = morphApplied ? morphSourceValues : engine.getSnapshot();
+    slotCoefficients[previousSlot] = morphApplied ? morphSourceCoefficients : engine.getCoefficients();
+
+    engine.applySettings(slotValues[slot], slotCoefficients[slot]);
+    morphApplied = false;
+    activeSlot = slot;
+    slotVersion++;
+
+    // The parameters still show the previous slot, until the message thread writes this one's values
+    slotSwitchParameters = parameterHandles.load();
+    slotSwitchValues = slotValues[slot];
+    slotSwitchHeld = true;
+    slotWriteBackPending = true;
+}
+
+bool MultiBandCompressorAudioProcessor::updateMorphEndpoints(const ParameterSnapshot& live)
+{
+    // Copy the other slot when it changed, or keep the last copy while the message thread holds the lock
+    const int version = slotVersion.load();
+    if (version != morphTargetVersion)
+    {
+        const SpinLock::ScopedTryLockType lock(slotLock);
+        if (! lock.isLocked())
+            return morphTargetVersion >= 0;
+
+        const int otherSlot = 1 - activeSlot.load();
+        morphTarget = slotValues[otherSlot];
+        morphTargetCoefficients = slotCoefficients[otherSlot];
+        morphTargetVersion = version;
+    }
+
+    // The active slot's coefficients are only designed when its cutoffs move
+    if (live.lowCutOff != morphSourceLowCutOff || live.highCutOff != morphSourceHighCutOff)
+    {
+        morphSourceCoefficients = Crossover::Coefficients::make(preparedSampleRate, live.lowCutOff, live.highCutOff);
+        morphSourceLowCutOff = live.lowCutOff;
+        morphSourceHighCutOff = live.highCutOff;
+    }
+
+    return true;
+}
+
+ParameterSnapshot MultiBandCompressorAudioProcessor::getSlotValues(int slot) const
+{
+    const SpinLock::ScopedLockType lock(slotLock);
+    return slotValues[jlimit(0, numSlots - 1, slot)];
+}
+
+void MultiBandCompressorAudioProcessor::selectSlot(int slot)
+{
+    if (auto* parameter = parameters.getParameter("abSlot"))
+    {
+        beginUndoTransaction("A/B Switch");
+        parameter->setValueNotifyingHost(slot > 0 ? 1.0f : 0.0f);
+        endUndoTransaction();
+    }
+}
+
+void MultiBandCompressorAudioProcessor::copyToOtherSlot()
+{
+    const ParameterSnapshot values = parameterHandles.load();
+    const auto coefficients = Crossover::Coefficients::make(preparedSampleRate, values.lowCutOff, values.highCutOff);
+
+    const SpinLock::ScopedLockType lock(slotLock);
+    const int otherSlot = 1 - activeSlot.load();
+    slotValues[otherSlot] = values;
+    slotCoefficients[otherSlot] = coefficients;
+    slotsInitialised = true;
+    slotVersion++;
+}
+
+void MultiBandCompressorAudioProcessor::updateSlotCoefficients()
+{
+    // Called with slotLock held
+    for (int slot = 0; slot < numSlots; slot++)
+        slotCoefficients[slot] = Crossover::Coefficients::make(preparedSampleRate, slotValues[slot].lowCutOff, slotValues[slot].highCutOff);
+
+    slotVersion++;
+}
+
+void MultiBandCompressorAudioProcessor::undo()
+{
+    // A transaction may touch every parameter, the engines take it as one change
+    const ScopedParameterWrite write(*this);
+    undoManager.undo();
+}
+
+void MultiBandCompressorAudioProcessor::redo()
+{
+    const ScopedParameterWrite write(*this);
+    undoManager.redo();
+}
+
+void MultiBandCompressorAudioProcessor::beginUndoTransaction(const String& name)
+{
+    // copyState() flushes the values set so far into the transaction that is still open
+    parameters.copyState();
+    undoManager.beginNewTransaction(name);
+}
+
+void MultiBandCompressorAudioProcessor::endUndoTransaction()
+{
+    // The values of this transaction go into it now, anything after them starts the next one
+    parameters.copyState();
+    undoManager.beginNewTransaction();
+}
+
+void MultiBandCompressorAudioProcessor::parameterValueChanged(int, float)
+{
+}
+
+void MultiBandCompressorAudioProcessor::parameterGestureChanged(int, bool gestureIsStarting)
+{
+    // Gestures come from the editor or the host before the first value of a drag or click, on the message thread.
+    // JUCE's attachments may already have begun a transaction, the values flushed here then stay in that one.
+    if (! MessageManager::existsAndIsCurrentThread())
+        return;
+
+    if (gestureIsStarting)
+        beginUndoTransaction();
+    else
+        endUndoTransaction();
+}
+
+void MultiBandCompressorAudioProcessor::writeParameters(const ParameterSnapshot& snapshot)
+{
+    // The engines pick the values up together once every parameter is written, only the ones that differ notify
+    const ScopedParameterWrite write(*this);
+
+    visitParameters(snapshot, [this] (const String& parameterID, float value)
+    {
+        if (auto* parameter = parameters.getParameter(parameterID))
+            if (parameter->convertTo0to1(value) != parameter->getValue())
+                parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    });
+}
+
+void MultiBandCompressorAudioProcessor::updateOverloadProtection()
+{
+    const bool active = fastMathActive.load(memory_order_relaxed);
+    const float load = loadMonitor.getAverageLoad();
+    const bool shouldBeActive = overloadProtection.load(memory_order_relaxed) && load > (active ? recoverLoad : degradeLoad);
+
+    if (shouldBeActive == active)
+        return;
+
+    fastMathActive.store(shouldBeActive, memory_order_relaxed);
+    for (auto& engine : engines)
+        engine.setFastMath(shouldBeActive);
+}
+
+void MultiBandCompressorAudioProcessor::writeBackSlotSwitch()
+{
+    if (! slotWriteBackPending.exchange(false))
+        return;
+
+    ParameterSnapshot values, parametersAtSwitch;
     {
-        buffer.addFrom(channel, 0, lowOutput, channel, 0, numSamples, 1.0 / 3.0);
-        buffer.addFrom(channel, 0, midOutput, channel, 0, numSamples, 1.0 / 3.0);
-        buffer.addFrom(channel, 0, highOutput, channel, 0, numSamples, 1.0 / 3.0);
+        const SpinLock::ScopedLockType lock(slotLock);
+        values = slotValues[activeSlot.load()];
+        parametersAtSwitch = slotSwitchParameters;
     }
 
-    // Apply the Overall Gain
-    buffer.applyGain(getOverallGain());
+    // Parameters moved since the switch, by automation or by hand, keep their new values.
+    // The values shown for the new slot are one transaction, apart from any gesture that may be open.
+    beginUndoTransaction("A/B Switch Values");
+    writeParameters(takeChanged(values, parametersAtSwitch, parameterHandles.load()));
+    endUndoTransaction();
+}
+
+void MultiBandCompressorAudioProcessor::timerCallback()
+{
+    // An A/B switch made by automation: show the new slot's values in the parameters
+    writeBackSlotSwitch();
+
+    // The audio thread only flips atomics, the log is written here
+    const bool fastMath = fastMathActive.load();
+    if (fastMath != loggedFastMath)
+    {
+        loggedFastMath = fastMath;
+        Logger::writeToLog(String(JucePlugin_Name) + (fastMath ? ": close to overload, switched to fast math" : ": load recovered, switched back to exact math")
+                           + " (average load " + String(loadMonitor.getAverageLoad() * 100.0f, 1) + "%)");
+    }
+
+    const int overloadCount = loadMonitor.getOverloadCount();
+    if (overloadCount != loggedOverloadCount)
+    {
+        Logger::writeToLog(String(JucePlugin_Name) + ": " + String(overloadCount - loggedOverloadCount) + " block(s) over the real-time budget");
+        loggedOverloadCount = overloadCount;
+    }
+}
+
+bool MultiBandCompressorAudioProcessor::hasChannelRole(ChannelGroups::Role role) const
+{
+    const AudioChannelSet inputLayout = getChannelLayoutOfBus(true, 0);
+    for (int channel = 0; channel < inputLayout.size(); channel++)
+        if (ChannelGroups::getRole(inputLayout.getTypeOfChannel(channel)) == role)
+            return true;
+
+    return false;
+}
+
+void MultiBandCompressorAudioProcessor::updateChannelGroups()
+{
+    bool linked[ChannelGroups::numLinkableRoles];
+    const int linking = readChannelLinking(linked);
+
+    if (linking != appliedChannelLinking)
+    {
+        channelGroups = ChannelGroups::make(channelRoles, numBufferChannels, linked);
+        appliedChannelLinking = linking;
+    }
+}
+
+int MultiBandCompressorAudioProcessor::readChannelLinking(bool* linked) const
+{
+    // One bit per group, so a change is seen without comparing the groups themselves
+    int linking = 0;
+    for (int role = 0; role < ChannelGroups::numLinkableRoles; role++)
+    {
+        linked[role] = channelLinking[role].load(memory_order_relaxed);
+        linking |= (linked[role] ? 1 : 0) << role;
+    }
+
+    return linking;
+}
+
+bool MultiBandCompressorAudioProcessor::isChangePending() const
+{
+    // A preset on its way in or fading, an A/B switch, or new surround linking
+    if (engineState.load() != engineIdle || (*slotParameter >= 0.5f ? 1 : 0) != activeSlot.load())
+        return true;
+
+    bool linked[ChannelGroups::numLinkableRoles];
+    if (readChannelLinking(linked) != appliedChannelLinking)
+        return true;
+
+    // A morph that moved, or whose other slot was copied to since the last grid line
+    const float morph = morphParameter->load();
+    if (morph != appliedMorph || (morph > 0.0f && slotVersion.load() != morphTargetVersion))
+        return true;
+
+    // A write under way or finished since the last read, or any parameter that moved since
+    if (parameterWriters.load() > 0 || parameterWriteSequence.load() != readSequence)
+        return true;
+
+    return ! (parameterHandles.load() == readValues);
 }
 
 AudioProcessorValueTreeState::ParameterLayout MultiBandCompressorAudioProcessor::createParameters()
@@ -314,6 +716,17 @@ AudioProcessorValueTreeState::ParameterLayout MultiBandCompressorAudioProcessor:
     parameterVector.push_back(make_unique<AudioParameterFloat>("kneeWidth",     "Knee Width",           5.0f, 100.0f,   5.0f));
     parameterVector.push_back(make_unique<AudioParameterFloat>("overallGain",   "Overall Gain",         0.0f, 4.0f,     1.0f));
 
+    // Compressor States
+    parameterVector.push_back(make_unique<AudioParameterBool>("lowEnabled",     "Low Band Compressor",  true));
+    parameterVector.push_back(make_unique<AudioParameterBool>("midEnabled",     "Mid Band Compressor",  true));
+    parameterVector.push_back(make_unique<AudioParameterBool>("highEnabled",    "High Band Compressor", true));
+
+    // A/B Slot, off for A and on for B
+    parameterVector.push_back(make_unique<AudioParameterBool>("abSlot",         "A/B Slot",             false));
+
+    // Morph from the active slot (0) to the other slot (1)
+    parameterVector.push_back(make_unique<AudioParameterFloat>("morph",         "Morph",                0.0f, 1.0f,     0.0f));
+
     return { parameterVector.begin(), parameterVector.end() };
 }
 
@@ -331,15 +744,93 @@ AudioProcessorEditor* MultiBandCompressorAudioProcessor::createEditor()
 //==============================================================================
 void MultiBandCompressorAudioProcessor::getStateInformation(MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // Every parameter, band states included, plus the plugin options as a compact binary ValueTree
+    ValueTree state = parameters.copyState();
+    state.setProperty("stateVersion", currentStateVersion, nullptr);
+    state.setProperty("overloadProtection", getOverloadProtection(), nullptr);
+    state.setProperty("linkFront", getChannelLinking(ChannelGroups::front), nullptr);
+    state.setProperty("linkSurround", getChannelLinking(ChannelGroups::surround), nullptr);
+    state.setProperty("linkHeight", getChannelLinking(ChannelGroups::height), nullptr);
+    state.setProperty("currentProgram", currentProgram, nullptr);
+
+    // A/B Slots, one child per slot with a property per parameter
+    ValueTree slots("Slots");
+    {
+        const SpinLock::ScopedLockType lock(slotLock);
+        for (auto& values : slotValues)
+        {
+            ValueTree slot("Slot");
+            visitParameters(values, [&slot] (const String& parameterID, float value) { slot.setProperty(parameterID, value, nullptr); });
+            slots.appendChild(slot, nullptr);
+        }
+    }
+    state.appendChild(slots, nullptr);
+
+    MemoryOutputStream stream(destData, false);
+    state.writeToStream(stream);
 }
 
 void MultiBandCompressorAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    ValueTree state = ValueTree::readFromData(data, (size_t) jmax(0, sizeInBytes));
+    if (! state.isValid() || ! state.hasType(parameters.state.getType()))
+        return;
+
+    // Newer formats only add to this one, so their known parameters are still restored
+    const int version = state.getProperty("stateVersion", 0);
+    jassert(version <= currentStateVersion);
+    ignoreUnused(version);
+
+    setOverloadProtection(state.getProperty("overloadProtection", false));
+    setChannelLinking(ChannelGroups::front, state.getProperty("linkFront", true));
+    setChannelLinking(ChannelGroups::surround, state.getProperty("linkSurround", true));
+    setChannelLinking(ChannelGroups::height, state.getProperty("linkHeight", true));
+    currentProgram = jlimit(0, numFactoryPresets - 1, (int) state.getProperty("currentProgram", 0));
+    state.removeProperty("stateVersion", nullptr);
+    state.removeProperty("overloadProtection", nullptr);
+    state.removeProperty("linkFront", nullptr);
+    state.removeProperty("linkSurround", nullptr);
+    state.removeProperty("linkHeight", nullptr);
+    state.removeProperty("currentProgram", nullptr);
+
+    const ValueTree slots = state.getChildWithName("Slots");
+    state.removeChild(slots, nullptr);
+
+    // Restoring the state we already have, as most session loads do, costs nothing
+    if (! state.isEquivalentTo(parameters.copyState()))
+    {
+        // One batched write instead of replacing the tree: only the parameters that differ are set and notify,
+        // the audio thread keeps the previous values until every one is in and rebuilds the coefficients once
+        const ScopedParameterWrite write(*this);
+
+        for (const auto& parameterState : state)
+            if (auto* parameter = parameters.getParameter(parameterState.getProperty("id").toString()))
+            {
+                const float value = parameter->convertTo0to1(parameterState.getProperty("value"));
+                if (value != parameter->getValue())
+                    parameter->setValueNotifyingHost(value);
+            }
+
+        // copyState() flushes the new values into the tree, so the restore is not left in the undo history
+        parameters.copyState();
+        undoManager.clearUndoHistory();
+    }
+
+    // A/B Slots: the restored parameters belong to the active slot, states before version 2 fill both with them
+    const ParameterSnapshot restored = parameterHandles.load();
+    const SpinLock::ScopedLockType lock(slotLock);
+
+    for (int slot = 0; slot < numSlots; slot++)
+    {
+        slotValues[slot] = restored;
+        const ValueTree slotState = slots.getChild(slot);
+        visitParameters(slotValues[slot], [&slotState] (const String& parameterID, float& value) { value = slotState.getProperty(parameterID, value); });
+    }
+
+    activeSlot = *slotParameter >= 0.5f ? 1 : 0;
+    slotValues[activeSlot.load()] = restored;
+    slotsInitialised = true;
+    updateSlotCoefficients();
 }
 
 //==============================================================================
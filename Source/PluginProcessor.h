@@ -10,6 +10,12 @@
 
 #include <JuceHeader.h>
 #include "Compressor.h"
+#include "LoadMonitor.h"
+#include "MultiBandEngine.h"
+#include "Parameters.h"
+#include "Presets.h"
+#include "SpectrumAnalyser.h"
+#include "StageProfiler.h"
 
 using namespace std;
 using namespace juce;
@@ -17,7 +23,7 @@ using namespace juce;
 //==============================================================================
 /**
 */
-class MultiBandCompressorAudioProcessor  : public juce::AudioProcessor
+class MultiBandCompressorAudioProcessor  : public juce::AudioProcessor, private Timer, private AudioProcessorParameter::Listener
 {
 public:
     //==============================================================================
@@ -58,167 +64,246 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     //==============================================================================
-    // Compressor States
-    void setLowCompressorState(int lowCompressorState)      { pLowCompressorState = lowCompressorState; }
-    void setMidCompressorState(int midCompressorState)      { pMidCompressorState = midCompressorState; }
-    void setHighCompressorState(int highCompressorState)    { pHighCompressorState = highCompressorState; }
+    // Processing Grid: parameters, A/B switches and preset fades are picked up every numSamples, counted from
+    // the start of playback, so the output does not depend on how the host splits its blocks (0 = once per block).
+    // A block is only split on the grid while a change waits for a grid line, otherwise it runs in one piece.
+    static constexpr int defaultProcessingGridSize = 32;
+    void setProcessingGridSize(int numSamples)              { processingGridSize = jmax(0, numSamples); }
+    int getProcessingGridSize() const                       { return processingGridSize.load(); }
 
     //==============================================================================
     // Getter Functions for each parameter
 
-    float getOverallGain()
-    {
-        auto pOverallGain = parameters.getRawParameterValue("overallGain")->load();
-        return pOverallGain;
-    }
-    float getKneeWidth()
-    {
-        auto kneeWidth = parameters.getRawParameterValue("kneeWidth")->load();
-        return kneeWidth;
-    }
+    float getOverallGain()          { return parameterHandles.overallGain->load(); }
+    float getKneeWidth()            { return parameterHandles.kneeWidth->load(); }
 
     // Cutoff Parameters
-    float getLowCutoff()
-    {
-        auto pLowPassCutoff = parameters.getRawParameterValue("lowCutOff")->load();
-        return pLowPassCutoff;
-    }
-    float getHighCutoff()
-    {
-        auto pHighPassCutoff = parameters.getRawParameterValue("highCutOff")->load();
-        return pHighPassCutoff;
-    }
+    float getLowCutoff()            { return parameterHandles.lowCutOff->load(); }
+    float getHighCutoff()           { return parameterHandles.highCutOff->load(); }
 
     // Low Compressor Parameters
-    float getLowGain()
-    {
-        auto pLowGain = parameters.getRawParameterValue("lowGain")->load();
-        return pLowGain;
-    }
-    float getLowThreshold()
-    {
-        auto pLowThreshold = parameters.getRawParameterValue("lowThresh")->load();
-        return pLowThreshold;
-    }
-    float getLowRatio()
-    {
-        auto pLowRatio = parameters.getRawParameterValue("lowRatio")->load();
-        return pLowRatio;
-    }
-    float getLowAttack()
-    {
-        auto pLowAttack = parameters.getRawParameterValue("lowAttack")->load();
-        return pLowAttack;
-    }
-    float getLowRelease()
-    {
-        auto pLowRelease = parameters.getRawParameterValue("lowRelease")->load();
-        return pLowRelease;
-    }
+    float getLowGain()              { return parameterHandles.low.gain->load(); }
+    float getLowThreshold()         { return parameterHandles.low.threshold->load(); }
+    float getLowRatio()             { return parameterHandles.low.ratio->load(); }
+    float getLowAttack()            { return parameterHandles.low.attack->load(); }
+    float getLowRelease()           { return parameterHandles.low.release->load(); }
 
     // Mid Compressor Parameters
-    float getMidGain()
-    {
-        auto pMidGain = parameters.getRawParameterValue("midGain")->load();
-        return pMidGain;
-    }
-    float getMidThreshold()
-    {
-        auto pMidThreshold = parameters.getRawParameterValue("midThresh")->load();
-        return pMidThreshold;
-    }
-    float getMidRatio()
-    {
-        auto pMidRatio = parameters.getRawParameterValue("midRatio")->load();
-        return pMidRatio;
-    }
-    float getMidAttack()
-    {
-        auto pMidAttack = parameters.getRawParameterValue("midAttack")->load();
-        return pMidAttack;
-    }
-    float getMidRelease()
-    {
-        auto pMidRelease = parameters.getRawParameterValue("midRelease")->load();
-        return pMidRelease;
-    }
+    float getMidGain()              { return parameterHandles.mid.gain->load(); }
+    float getMidThreshold()         { return parameterHandles.mid.threshold->load(); }
+    float getMidRatio()             { return parameterHandles.mid.ratio->load(); }
+    float getMidAttack()            { return parameterHandles.mid.attack->load(); }
+    float getMidRelease()           { return parameterHandles.mid.release->load(); }
 
     // High Compressor Parameters
-    float getHighGain()
-    {
-        auto pHighGain = parameters.getRawParameterValue("highGain")->load();
-        return pHighGain;
-    }
-    float getHighThreshold()
-    {
-        auto pHighThreshold = parameters.getRawParameterValue("highThresh")->load();
-        return pHighThreshold;
-    }
-    float getHighRatio()
-    {
-        auto pHighRatio = parameters.getRawParameterValue("highRatio")->load();
-        return pHighRatio;
-    }
-    float getHighAttack()
-    {
-        auto pHighAttack = parameters.getRawParameterValue("highAttack")->load();
-        return pHighAttack;
-    }
-    float getHighRelease()
-    {
-        auto pHighRelease = parameters.getRawParameterValue("highRelease")->load();
-        return pHighRelease;
-    }
+    float getHighGain()             { return parameterHandles.high.gain->load(); }
+    float getHighThreshold()        { return parameterHandles.high.threshold->load(); }
+    float getHighRatio()            { return parameterHandles.high.ratio->load(); }
+    float getHighAttack()           { return parameterHandles.high.attack->load(); }
+    float getHighRelease()          { return parameterHandles.high.release->load(); }
+
+    // All parameter values at once
+    ParameterSnapshot getParameterSnapshot() const  { return parameterHandles.load(); }
 
     // Compressor States
-    float getLowCompressorState()                           { return pLowCompressorState; }
-    float getMidCompressorState()                           { return pMidCompressorState; }
-    float getHighCompressorState()                          { return pHighCompressorState; }
+    bool getLowCompressorState()    { return parameterHandles.low.enabled->load() >= 0.5f; }
+    bool getMidCompressorState()    { return parameterHandles.mid.enabled->load() >= 0.5f; }
+    bool getHighCompressorState()   { return parameterHandles.high.enabled->load() >= 0.5f; }
+
+    // Band Meters
+    CompressorMeter& getLowMeter()  { return lowMeter; }
+    CompressorMeter& getMidMeter()  { return midMeter; }
+    CompressorMeter& getHighMeter() { return highMeter; }
+
+    // Spectrum Analyser, with the FFT size as a power of two and the frames per second
+    SpectrumAnalyser& getAnalyser() { return analyser; }
+    void setAnalyserSettings(int fftOrder, int updateRateHz)    { analyser.setup(fftOrder, updateRateHz); }
+
+   #if MBC_ENABLE_PROFILING
+    // Per-stage timing of the DSP path
+    StageProfiler& getProfiler()    { return profiler; }
+   #endif
+
+    // A/B Comparison: the parameters edit the active slot, switching is done with the "abSlot" parameter
+    int getActiveSlot() const       { return activeSlot.load(); }
+    ParameterSnapshot getSlotValues(int slot) const;
+    void selectSlot(int slot);
+    void copyToOtherSlot();
+
+    // Message thread: writes the values of a slot that automation switched to into the parameters, the timer calls it
+    void writeBackSlotSwitch();
+
+    // CPU Load, and the switch to fast math when the average load nears the block budget
+    LoadMonitor& getLoadMonitor()                           { return loadMonitor; }
+    void setOverloadProtection(bool shouldDegrade)          { overloadProtection = shouldDegrade; }
+    bool getOverloadProtection() const                      { return overloadProtection.load(); }
+    bool isFastMathActive() const                           { return fastMathActive.load(); }
+
+    // Surround Linking: whether the channels of a group share one detector, LFE channels are never compressed
+    void setChannelLinking(ChannelGroups::Role role, bool shouldLink)   { channelLinking[role] = shouldLink; }
+    bool getChannelLinking(ChannelGroups::Role role) const              { return channelLinking[role].load(); }
+    bool hasChannelRole(ChannelGroups::Role role) const;
+
+    // Undo History: one transaction per gesture, preset load and A/B switch, bounded to undoUnitsToKeep units beyond
+    // the last undoTransactionsToKeep. Every gesture on a parameter, from the editor or the host, starts its own.
+    static constexpr int            undoUnitsToKeep = 5000;
+    static constexpr int            undoTransactionsToKeep = 20;
+    UndoManager                     undoManager { undoUnitsToKeep, undoTransactionsToKeep };
+    void undo();
+    void redo();
 
     AudioProcessorValueTreeState    parameters;
 
 private:
     
-    //============================FILTER DEFINITIONS============================================//
-    // Low Frequency Band Left and Right
-    IIRFilter   lowBandFilterL1,        lowBandFilterL2,        lowBandFilterR1,        lowBandFilterR2;
-
-    // Mid Frequency Band Left and Right
-    IIRFilter   lowMidBandFilterL1,     lowMidBandFilterL2,     lowMidBandFilterR1,     lowMidBandFilterR2;
-    IIRFilter   highMidBandFilterL1,    highMidBandFilterL2,    highMidBandFilterR1,    highMidBandFilterR2;
+    //============================ENGINE DEFINITIONS============================================//
+    // DSP Engines: the active one, and a second one that a preset switch prepares and crossfades to
+    enum EngineState
+    {
+        engineIdle = 0,     // only the active engine runs
+        enginePreparing,    // the message thread is preparing the other engine, the active one holds its values
+        engineReady,        // the other engine is prepared, the audio thread starts the crossfade
+        engineFading        // both engines run, the audio thread swaps them at the end of the crossfade
+    };
+
+    MultiBandEngine     engines[2];
+    atomic<int>         activeEngine { 0 };
+    atomic<int>         engineState { engineIdle };
+    atomic<bool>        enginesPrepared { false };
+
+    // Preset Crossfade, the incoming engine runs silently for the warm-up so its filters and detectors settle
+    static constexpr double presetWarmUpTime = 0.02;
+    static constexpr double presetFadeTime = 0.01;
+    AudioSampleBuffer   fadeBuffer;
+    int                 fadePosition = 0;
+    int                 warmUpSamples = 0;
+    int                 fadeSamples = 1;
+    int                 currentProgram = 0;
+
+    // Processing Setup, from prepareToPlay
+    double              preparedSampleRate = 44100.0;
+    int                 numBufferChannels = 0;      // input channels, a mono input is copied to the outputs after processing
+    int                 maxSubBlockSize = 1;
+
+    // Band Meters, shared by both engines
+    CompressorMeter     lowMeter;
+    CompressorMeter     midMeter;
+    CompressorMeter     highMeter;
+
+    // Spectrum Analyser
+    SpectrumAnalyser    analyser;
+
+   #if MBC_ENABLE_PROFILING
+    // Stage Timing
+    StageProfiler       profiler;
+   #endif
 
-    // High Frequency Band Left and Right
-    IIRFilter   highBandFilterL1,       highBandFilterL2,       highBandFilterR1,       highBandFilterR2;
+    // CPU Load and Overload Protection, with hysteresis between the two loads
+    static constexpr float  degradeLoad = 0.8f;
+    static constexpr float  recoverLoad = 0.5f;
+    LoadMonitor             loadMonitor;
+    atomic<bool>            overloadProtection { false };
+    atomic<bool>            fastMathActive { false };
+
+    // Surround Linking: the roles come from the bus layout in prepareToPlay, the audio thread rebuilds the groups
+    ChannelGroups::Role     channelRoles[ChannelGroups::maxChannels] {};
+    atomic<bool>            channelLinking[ChannelGroups::numLinkableRoles] { { true }, { true }, { true } };
+    ChannelGroups           channelGroups;
+    int                     appliedChannelLinking = -1;
+
+    // Last state written to the log, message thread only
+    bool                    loggedFastMath = false;
+    int                     loggedOverloadCount = 0;
+
+    // A/B Slots with their crossover coefficients, computed off the audio thread.
+    // The audio thread only try-locks slotLock, and skips a switch to the next block if it is taken.
+    static constexpr int        numSlots = 2;
+    mutable SpinLock            slotLock;
+    ParameterSnapshot           slotValues[numSlots] {};
+    Crossover::Coefficients     slotCoefficients[numSlots];
+    atomic<int>                 activeSlot { 0 };
+    bool                        slotsInitialised = false;
+    atomic<float>*              slotParameter = nullptr;
+    atomic<int>                 slotVersion { 0 };
+
+    // After a switch the engine runs the slot's values while the parameters still show the previous slot.
+    // Any parameter that moves away from where it stood at the switch is taken at once, the others keep the
+    // slot's values until the message thread has written them. slotSwitchParameters is written under slotLock.
+    ParameterSnapshot           slotSwitchParameters {};
+    ParameterSnapshot           slotSwitchValues {};        // audio thread only
+    bool                        slotSwitchHeld = false;     // audio thread only
+    atomic<bool>                slotWriteBackPending { false };
+
+    // Morph from the active slot toward the other one, audio thread only.
+    // The other slot is copied when slotVersion moves, the active slot's coefficients when its cutoffs move.
+    atomic<float>*              morphParameter = nullptr;
+    ParameterSnapshot           morphTarget {};
+    Crossover::Coefficients     morphTargetCoefficients;
+    Crossover::Coefficients     morphSourceCoefficients;
+    ParameterSnapshot           morphSourceValues {};   // the active slot's own values, what an A/B switch keeps
+    bool                        morphApplied = false;   // whether the active engine runs blended values
+    int                         morphTargetVersion = -1;
+    float                       morphSourceLowCutOff = -1;
+    float                       morphSourceHighCutOff = -1;
+
+    // Saved State, versioned so later formats can migrate older sessions
+    // 1: parameters and options, 2: A/B slots
+    static constexpr int        currentStateVersion = 2;
+
+    // Writers of a whole state, preset or undo step, which may nest. The engines keep their last values while
+    // any is running, and drop a snapshot if the sequence moved while it was read, so they never see half a state.
+    atomic<int>                 parameterWriters { 0 };
+    atomic<uint32>              parameterWriteSequence { 0 };
+
+    struct ScopedParameterWrite
+    {
+        explicit ScopedParameterWrite(MultiBandCompressorAudioProcessor& p) : processor(p)
+        {
+            ++processor.parameterWriters;
+            ++processor.parameterWriteSequence;
+        }
 
-    // Coefficient values
-    IIRCoefficients coefficients;
+        ~ScopedParameterWrite()
+        {
+            ++processor.parameterWriteSequence;
+            --processor.parameterWriters;
+        }
 
-    // Compressors
-    Compressor   lowCompressor;
-    Compressor   midCompressor;
-    Compressor   highCompressor;
+        MultiBandCompressorAudioProcessor& processor;
+    };
 
     // Parameters
     int                         numChannels;
-    float                       pOverallGain;
-    float                       kneeWidth;
+    ParameterHandles            parameterHandles;
+    atomic<int>                 processingGridSize { defaultProcessingGridSize };
+    int                         gridPosition = 0;       // samples since the last grid line, audio thread only
 
-    // Cutoff Frequencies
-    float                       pLowPassCutoff;
-    float                       pHighPassCutoff;
-
-    // Compressor Parameters
-    float           pLowGain,   pLowThreshold,  pLowRatio,  pLowAttack,     pLowRelease;
-    float           pMidGain,   pMidThreshold,  pMidRatio,  pMidAttack,     pMidRelease;
-    float           pHighGain,  pHighThreshold, pHighRatio, pHighAttack,    pHighRelease;
-
-    // Compressor States
-    int             pLowCompressorState;
-    int             pMidCompressorState;
-    int             pHighCompressorState;
+    // What the last grid line took, so a change still waiting for one is seen without reading it, audio thread only
+    ParameterSnapshot           readValues {};
+    uint32                      readSequence = 0;
+    float                       appliedMorph = -1;
 
     //=====================FUNCTIONS===============================================================//
     AudioProcessorValueTreeState::ParameterLayout createParameters();
+    void writeParameters(const ParameterSnapshot& snapshot);
+    void processPresetCrossfade(AudioSampleBuffer& buffer, int startSample, int numSamples, bool onGrid);
+    float getPresetMix(int position) const;
+    bool readParameters(ParameterSnapshot& snapshot);
+    void switchSlot(int slot);
+    bool updateMorphEndpoints(const ParameterSnapshot& live);
+    void updateSlotCoefficients();
+    void updateOverloadProtection();
+    void updateChannelGroups();
+    int readChannelLinking(bool* linked) const;
+
+    // Message thread: the parameter values are copied to the state on a timer, so each transaction flushes them
+    // at its start, into the previous transaction, and at its end, into its own
+    void beginUndoTransaction(const String& name = String());
+    void endUndoTransaction();
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
+    bool isChangePending() const;
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiBandCompressorAudioProcessor)
 };
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    This file contains the factory preset bank, exposed to the host as the
+    plugin's programs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Parameters.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+struct FactoryPreset
+{
+    const char* name;
+    ParameterSnapshot values;
+};
+
+// Cutoffs, knee width, overall gain, then { threshold, ratio, attack, release, gain, enabled } per band
+static const FactoryPreset factoryPresets[] =
+{
+    { "Default",            { 450.0f, 2500.0f,  5.0f, 1.0f, {   0.0f,  1.0f,  5.0f,  5.0f, 1.0f, 1.0f },
+                                                             {   0.0f,  1.0f,  5.0f,  5.0f, 1.0f, 1.0f },
+                                                             {   0.0f,  1.0f,  5.0f,  5.0f, 1.0f, 1.0f } } },
+    { "Gentle Glue",        { 450.0f, 2500.0f, 10.0f, 1.0f, { -20.0f,  2.0f, 30.0f, 80.0f, 1.2f, 1.0f },
+                                                             { -20.0f,  2.0f, 30.0f, 80.0f, 1.2f, 1.0f },
+                                                             { -20.0f,  2.0f, 30.0f, 80.0f, 1.2f, 1.0f } } },
+    { "Vocal Control",      { 250.0f, 3000.0f,  8.0f, 1.0f, { -30.0f,  3.0f, 10.0f, 60.0f, 1.0f, 1.0f },
+                                                             { -24.0f,  4.0f,  5.0f, 40.0f, 1.4f, 1.0f },
+                                                             { -28.0f,  3.0f,  5.0f, 30.0f, 1.1f, 1.0f } } },
+    { "Bass Tamer",         { 200.0f, 2500.0f,  5.0f, 1.0f, { -30.0f,  6.0f, 10.0f, 80.0f, 1.3f, 1.0f },
+                                                             {   0.0f,  1.0f,  5.0f,  5.0f, 1.0f, 0.0f },
+                                                             {   0.0f,  1.0f,  5.0f,  5.0f, 1.0f, 0.0f } } },
+    { "De-Esser",           { 450.0f, 4000.0f,  5.0f, 1.0f, {   0.0f,  1.0f,  5.0f,  5.0f, 1.0f, 0.0f },
+                                                             {   0.0f,  1.0f,  5.0f,  5.0f, 1.0f, 0.0f },
+                                                             { -40.0f,  8.0f,  5.0f, 20.0f, 1.0f, 1.0f } } },
+    { "Mastering Limit",    { 150.0f, 4000.0f,  5.0f, 1.0f, { -12.0f, 10.0f,  5.0f, 50.0f, 1.5f, 1.0f },
+                                                             { -12.0f, 10.0f,  5.0f, 50.0f, 1.5f, 1.0f },
+                                                             { -12.0f, 10.0f,  5.0f, 50.0f, 1.5f, 1.0f } } },
+};
+
+static constexpr int numFactoryPresets = (int) (sizeof(factoryPresets) / sizeof(factoryPresets[0]));
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    This file contains the display of each band's static compression curve
+    and of the combined crossover magnitude response.
+
+  ==============================================================================
+*/
+
+#include "ResponseDisplay.h"
+#include "Compressor.h"
+#include "Crossover.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+ResponseDisplay::ResponseDisplay()
+{
+    setInterceptsMouseClicks(false, false);
+}
+
+ResponseDisplay::~ResponseDisplay()
+{
+}
+
+void ResponseDisplay::update(const ParameterSnapshot& snapshot, double sampleRate)
+{
+    const bool curvesChanged = ! (snapshot.low == curveSnapshot.low && snapshot.mid == curveSnapshot.mid
+                                  && snapshot.high == curveSnapshot.high && snapshot.kneeWidth == curveSnapshot.kneeWidth);
+    const bool crossoverChanged = snapshot.lowCutOff != curveSnapshot.lowCutOff || snapshot.highCutOff != curveSnapshot.highCutOff
+                               || sampleRate != curveSampleRate;
+
+    if (! curvesChanged && ! crossoverChanged)
+        return;
+
+    curveSnapshot = snapshot;
+    curveSampleRate = sampleRate;
+
+    if (curvesChanged)
+        buildCurves();
+    if (crossoverChanged)
+        buildCrossoverResponse();
+
+    repaint();
+}
+
+void ResponseDisplay::resized()
+{
+    // Transfer curves on the left, crossover response on the right
+    auto area = getLocalBounds().toFloat();
+    curveArea = area.removeFromLeft(area.getWidth() / 2).reduced(4.0f);
+    crossoverArea = area.reduced(4.0f);
+
+    buildCurves();
+    buildCrossoverResponse();
+}
+
+void ResponseDisplay::paint(Graphics& g)
+{
+    // Only the cached paths are drawn here, nothing is evaluated
+    g.setColour(Colours::white.withAlpha(0.08f));
+    g.fillRoundedRectangle(curveArea, 3.0f);
+    g.fillRoundedRectangle(crossoverArea, 3.0f);
+
+    g.setColour(Colours::lightblue);
+    g.strokePath(lowCurve, PathStrokeType(1.5f));
+    g.setColour(Colours::lightgreen);
+    g.strokePath(midCurve, PathStrokeType(1.5f));
+    g.setColour(Colours::orange);
+    g.strokePath(highCurve, PathStrokeType(1.5f));
+
+    g.setColour(Colours::white);
+    g.strokePath(crossoverResponse, PathStrokeType(1.5f));
+}
+
+//==============================================================================
+void ResponseDisplay::buildCurves()
+{
+    lowCurve = buildCurve(curveSnapshot.low);
+    midCurve = buildCurve(curveSnapshot.mid);
+    highCurve = buildCurve(curveSnapshot.high);
+}
+
+Path ResponseDisplay::buildCurve(const BandParameters& band) const
+{
+    Path curve;
+    const int numPoints = jmax(2, (int) curveArea.getWidth());
+    const float makeUpGain = Decibels::gainToDecibels(band.gain);
+
+    for (int i = 0; i < numPoints; i++)
+    {
+        const float inputGain = jmap((float) i, 0.0f, (float) (numPoints - 1), minDecibels, 0.0f);
+
+        // The compressor only applies its make up gain when the threshold is 0 dB
+        float outputGain = inputGain;
+        if (band.threshold < 0)
+            outputGain = Compressor::computeOutputGain(inputGain, band.threshold, band.ratio, curveSnapshot.kneeWidth);
+        outputGain += makeUpGain;
+
+        const float x = jmap(inputGain, minDecibels, 0.0f, curveArea.getX(), curveArea.getRight());
+        const float y = jmap(jlimit(minDecibels, 0.0f, outputGain), minDecibels, 0.0f, curveArea.getBottom(), curveArea.getY());
+
+        if (i == 0)
+            curve.startNewSubPath(x, y);
+        else
+            curve.lineTo(x, y);
+    }
+
+    return curve;
+}
+
+void ResponseDisplay::buildCrossoverResponse()
+{
+    crossoverResponse.clear();
+
+    const double sampleRate = curveSampleRate > 0 ? curveSampleRate : 44100.0;
+    if (curveSnapshot.lowCutOff <= 0 || curveSnapshot.highCutOff <= 0)
+        return;
+
+    // The same coefficients and stages as the crossover, so the curve cannot drift from the DSP
+    const auto coefficients = Crossover::Coefficients::make(sampleRate, curveSnapshot.lowCutOff, curveSnapshot.highCutOff);
+
+    const int numPoints = jmax(2, (int) crossoverArea.getWidth());
+    const float range = 24.0f;
+
+    for (int i = 0; i < numPoints; i++)
+    {
+        const double frequency = minFrequency * pow(maxFrequency / minFrequency, (double) i / (numPoints - 1));
+        const double omega = MathConstants<double>::twoPi * jmin(frequency, sampleRate * 0.49) / sampleRate;
+
+        // The bands are summed at a third each
+        complex<double> low, mid, high;
+        coefficients.getBandResponses(omega, low, mid, high);
+        const float magnitude = Decibels::gainToDecibels((float) abs((low + mid + high) / 3.0), -range);
+
+        const float x = crossoverArea.getX() + crossoverArea.getWidth() * (float) i / (float) (numPoints - 1);
+        const float y = jmap(jlimit(-range, 0.0f, magnitude), -range, 0.0f, crossoverArea.getBottom(), crossoverArea.getY());
+
+        if (i == 0)
+            crossoverResponse.startNewSubPath(x, y);
+        else
+            crossoverResponse.lineTo(x, y);
+    }
+}
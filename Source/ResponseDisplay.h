@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    This file contains the display of each band's static compression curve
+    and of the combined crossover magnitude response.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Parameters.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+class ResponseDisplay  : public Component
+{
+public:
+    ResponseDisplay();
+    ~ResponseDisplay() override;
+
+    void paint(Graphics&) override;
+    void resized() override;
+
+    // Rebuilds the cached paths only when a parameter they depend on changed
+    void update(const ParameterSnapshot& snapshot, double sampleRate);
+
+private:
+    // Curves are built from these values
+    ParameterSnapshot curveSnapshot {};
+    double curveSampleRate = 0;
+
+    // Cached Paths
+    Path lowCurve, midCurve, highCurve;
+    Path crossoverResponse;
+    Rectangle<float> curveArea, crossoverArea;
+
+    static constexpr float minDecibels = -80.0f;
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+
+    void buildCurves();
+    void buildCrossoverResponse();
+    Path buildCurve(const BandParameters& band) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponseDisplay)
+};
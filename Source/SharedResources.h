@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    This file contains the read-only data shared by every instance of the
+    plugin in the process, held through juce::SharedResourcePointer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+// FFT plans and Hann windows, one per size, built the first time an analyser asks for it
+class FftPlans
+{
+public:
+    struct Plan
+    {
+        explicit Plan(int order)
+            : fft(order), window((size_t) 1 << order, dsp::WindowingFunction<float>::hann, false) {}
+
+        // Neither changes once built, so any number of analysis threads can use them
+        const dsp::FFT fft;
+        dsp::WindowingFunction<float> window;
+    };
+
+    Plan& getPlan(int order)
+    {
+        order = jlimit(0, maxOrder, order);
+
+        const ScopedLock lock(planLock);
+        if (plans[order] == nullptr)
+            plans[order] = make_unique<Plan>(order);
+
+        return *plans[order];
+    }
+
+private:
+    static constexpr int maxOrder = 15;
+
+    CriticalSection planLock;
+    unique_ptr<Plan> plans[maxOrder + 1];
+};
+
+//==============================================================================
+// Decoded artwork and fonts of the editor
+struct EditorResources
+{
+    const Image background = ImageFileFormat::loadFrom(BinaryData::background_png, BinaryData::background_pngSize);
+
+    const Font titleFont { 35.0f };
+    const Font labelFont { 18.0f };
+    const Font smallFont { 13.0f };
+};
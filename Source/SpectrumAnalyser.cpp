@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum analyser. The audio thread only copies
+    samples into a ring buffer, the FFT frames run on a background thread.
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyser.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+SpectrumAnalyser::SpectrumAnalyser()
+    : Thread("Spectrum Analyser")
+{
+}
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    stopAnalysis();
+}
+
+void SpectrumAnalyser::setup(int newFftOrder, int newUpdateRateHz)
+{
+    // The analysis thread picks the new size up before its next frame
+    fftOrder = jlimit(minFftOrder, maxFftOrder, newFftOrder);
+    updateRateHz = jlimit(1, 60, newUpdateRateHz);
+}
+
+void SpectrumAnalyser::startAnalysis()
+{
+    // The ring buffers are only needed once someone looks. They are allocated on the first start only,
+    // before the audio thread can ever see active, and never reassigned, so a push never meets a moving buffer.
+    if (inputChannel.ring.empty())
+    {
+        inputChannel.ring.assign(ringSize, 0.0f);
+        outputChannel.ring.assign(ringSize, 0.0f);
+    }
+
+    // Release: the audio thread that sees active also sees the allocated buffers
+    active.store(true, memory_order_release);
+    startThread();
+}
+
+void SpectrumAnalyser::stopAnalysis()
+{
+    active.store(false, memory_order_release);
+    stopThread(1000);
+}
+
+//==============================================================================
+void SpectrumAnalyser::pushInput(const AudioSampleBuffer& buffer, int numChannels, int startSample, int numSamples)
+{
+    push(inputChannel, buffer, numChannels, startSample, numSamples);
+}
+
+void SpectrumAnalyser::pushOutput(const AudioSampleBuffer& buffer, int numChannels, int startSample, int numSamples)
+{
+    push(outputChannel, buffer, numChannels, startSample, numSamples);
+}
+
+void SpectrumAnalyser::push(Channel& channel, const AudioSampleBuffer& buffer, int numChannels, int startSample, int numSamples)
+{
+    // Nothing to do while no one is looking
+    if (! active.load(memory_order_acquire) || numChannels <= 0)
+        return;
+
+    const float scale = 1.0f / (float) numChannels;
+    int position = channel.writePosition.load(memory_order_relaxed);
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        float sum = 0;
+        for (int c = 0; c < numChannels; c++)
+            sum += buffer.getReadPointer(c)[startSample + i];
+
+        channel.ring[position] = sum * scale;
+        position = (position + 1) & (ringSize - 1);
+    }
+
+    channel.writePosition.store(position, memory_order_release);
+}
+
+//==============================================================================
+void SpectrumAnalyser::run()
+{
+    while (! threadShouldExit())
+    {
+        // Take the shared FFT plan when the size was changed
+        const int order = fftOrder.load();
+        if (plan == nullptr || plan->fft.getSize() != (1 << order))
+        {
+            plan = &fftPlans->getPlan(order);
+            fftData.assign((size_t) (2 << order), 0.0f);
+            inputChannel.averaged.assign((size_t) (1 << order) / 2 + 1, -100.0f);
+            outputChannel.averaged.assign((size_t) (1 << order) / 2 + 1, -100.0f);
+        }
+
+        analyse(inputChannel);
+        analyse(outputChannel);
+        newSpectrum = true;
+
+        // One frame per update period bounds the analyser's own cost
+        wait(jmax(1, 1000 / updateRateHz.load()));
+    }
+}
+
+void SpectrumAnalyser::analyse(Channel& channel)
+{
+    const int fftSize = plan->fft.getSize();
+
+    // Take the latest fftSize samples from the ring buffer
+    const int end = channel.writePosition.load(memory_order_acquire);
+    for (int i = 0; i < fftSize; i++)
+        fftData[(size_t) i] = channel.ring[(size_t) ((end - fftSize + i) & (ringSize - 1))];
+
+    plan->window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+    plan->fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    // Scale so a full-scale sine reads 0 dB through the Hann window, then average
+    const float scale = 4.0f / (float) fftSize;
+    for (size_t bin = 0; bin < channel.averaged.size(); bin++)
+    {
+        const float level = Decibels::gainToDecibels(fftData[bin] * scale, -100.0f);
+        channel.averaged[bin] = averaging * channel.averaged[bin] + (1.0f - averaging) * level;
+    }
+
+    const SpinLock::ScopedLockType lock(spectrumLock);
+    channel.published = channel.averaged;
+}
+
+bool SpectrumAnalyser::getSpectra(vector<float>& inputSpectrum, vector<float>& outputSpectrum)
+{
+    if (! newSpectrum.exchange(false))
+        return false;
+
+    const SpinLock::ScopedLockType lock(spectrumLock);
+    inputSpectrum = inputChannel.published;
+    outputSpectrum = outputChannel.published;
+    return true;
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum analyser. The audio thread only copies
+    samples into a ring buffer, the FFT frames run on a background thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedResources.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+class SpectrumAnalyser  : public Thread
+{
+public:
+    SpectrumAnalyser();
+    ~SpectrumAnalyser() override;
+
+    // Limits of the FFT size, as powers of two
+    static constexpr int minFftOrder = 9;
+    static constexpr int maxFftOrder = 13;
+
+    // Message thread: FFT size and the number of frames analysed per second
+    void setup(int newFftOrder, int newUpdateRateHz);
+    void startAnalysis();
+    void stopAnalysis();
+
+    // Audio thread: copy the mono sum of a block into the ring buffer
+    void prepare(double newSampleRate)          { sampleRate = newSampleRate; }
+    void pushInput(const AudioSampleBuffer& buffer, int numChannels, int startSample, int numSamples);
+    void pushOutput(const AudioSampleBuffer& buffer, int numChannels, int startSample, int numSamples);
+
+    // Message thread: copy the latest averaged spectra in dB, false if nothing new
+    bool getSpectra(vector<float>& inputSpectrum, vector<float>& outputSpectrum);
+    double getSampleRate() const                { return sampleRate.load(); }
+
+    void run() override;
+
+private:
+    struct Channel
+    {
+        vector<float>   ring;                   // allocated by startAnalysis(), then written by the audio thread only
+        atomic<int>     writePosition { 0 };
+        vector<float>   averaged;               // analysis thread only
+        vector<float>   published;              // guarded by spectrumLock
+    };
+
+    static constexpr int ringSize = 2 << maxFftOrder;
+    static constexpr float averaging = 0.7f;
+
+    void push(Channel& channel, const AudioSampleBuffer& buffer, int numChannels, int startSample, int numSamples);
+    void analyse(Channel& channel);
+
+    Channel inputChannel;
+    Channel outputChannel;
+
+    // Analysis thread state, the plans are shared by every analyser in the process
+    SharedResourcePointer<FftPlans>             fftPlans;
+    FftPlans::Plan*                             plan = nullptr;
+    vector<float>                               fftData;
+
+    atomic<int>     fftOrder        { 11 };
+    atomic<int>     updateRateHz    { 30 };
+    atomic<double>  sampleRate      { 44100.0 };
+    atomic<bool>    active          { false };
+    atomic<bool>    newSpectrum     { false };
+    SpinLock        spectrumLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyser)
+};
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    This file contains the display of the input and output spectra with the
+    crossover frequencies overlaid.
+
+  ==============================================================================
+*/
+
+#include "SpectrumDisplay.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+SpectrumDisplay::SpectrumDisplay(SpectrumAnalyser& analyserToDisplay)
+    : analyser(analyserToDisplay)
+{
+    setInterceptsMouseClicks(false, false);
+}
+
+SpectrumDisplay::~SpectrumDisplay()
+{
+}
+
+void SpectrumDisplay::update(float lowCutOff, float highCutOff)
+{
+    bool changed = false;
+
+    if (lowCutOff != lowCutOffFrequency || highCutOff != highCutOffFrequency)
+    {
+        lowCutOffFrequency = lowCutOff;
+        highCutOffFrequency = highCutOff;
+        changed = true;
+    }
+
+    if (analyser.getSpectra(inputSpectrum, outputSpectrum))
+    {
+        buildPath(inputPath, inputSpectrum);
+        buildPath(outputPath, outputSpectrum);
+        changed = true;
+    }
+
+    if (changed)
+        repaint();
+}
+
+void SpectrumDisplay::resized()
+{
+    buildPath(inputPath, inputSpectrum);
+    buildPath(outputPath, outputSpectrum);
+}
+
+void SpectrumDisplay::paint(Graphics& g)
+{
+    g.setColour(Colours::white.withAlpha(0.08f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 3.0f);
+
+    // Pre-compression spectrum behind the post-compression one
+    g.setColour(Colours::grey);
+    g.strokePath(inputPath, PathStrokeType(1.0f));
+    g.setColour(Colours::lightblue);
+    g.strokePath(outputPath, PathStrokeType(1.5f));
+
+    // Crossover Frequencies
+    g.setColour(Colours::orange);
+    g.drawVerticalLine(roundToInt(frequencyToX(lowCutOffFrequency)), 0.0f, (float) getHeight());
+    g.drawVerticalLine(roundToInt(frequencyToX(highCutOffFrequency)), 0.0f, (float) getHeight());
+}
+
+float SpectrumDisplay::frequencyToX(float frequency) const
+{
+    const float proportion = log(jmax(frequency, minFrequency) / minFrequency) / log(maxFrequency / minFrequency);
+    return proportion * (float) getWidth();
+}
+
+void SpectrumDisplay::buildPath(Path& path, const vector<float>& spectrum) const
+{
+    path.clear();
+
+    if (spectrum.size() < 2)
+        return;
+
+    // Bin spacing follows from the spectrum length and the sample rate
+    const float binWidth = (float) analyser.getSampleRate() / (float) ((spectrum.size() - 1) * 2);
+    const float height = (float) getHeight();
+
+    for (size_t bin = 1; bin < spectrum.size(); bin++)
+    {
+        const float frequency = (float) bin * binWidth;
+        if (frequency > maxFrequency)
+            break;
+
+        const float x = frequencyToX(frequency);
+        const float y = jmap(jlimit(minDecibels, 0.0f, spectrum[bin]), minDecibels, 0.0f, height, 0.0f);
+
+        if (path.isEmpty())
+            path.startNewSubPath(x, y);
+        else
+            path.lineTo(x, y);
+    }
+}
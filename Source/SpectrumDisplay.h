@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    This file contains the display of the input and output spectra with the
+    crossover frequencies overlaid.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectrumAnalyser.h"
+
+using namespace std;
+using namespace juce;
+
+//==============================================================================
+class SpectrumDisplay  : public Component
+{
+public:
+    SpectrumDisplay(SpectrumAnalyser& analyserToDisplay);
+    ~SpectrumDisplay() override;
+
+    void paint(Graphics&) override;
+    void resized() override;
+
+    // Picks up new spectra and crossover frequencies, repaints only if something changed
+    void update(float lowCutOff, float highCutOff);
+
+private:
+    SpectrumAnalyser& analyser;
+
+    vector<float> inputSpectrum;
+    vector<float> outputSpectrum;
+    Path inputPath;
+    Path outputPath;
+
+    float lowCutOffFrequency = 0;
+    float highCutOffFrequency = 0;
+
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+    static constexpr float minDecibels = -90.0f;
+
+    float frequencyToX(float frequency) const;
+    void buildPath(Path& path, const vector<float>& spectrum) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumDisplay)
+};
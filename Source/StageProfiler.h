@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    This file contains the optional per-stage timing of the DSP path.
+
+    Add MBC_ENABLE_PROFILING=1 to the exporter's preprocessor definitions to
+    compile it in. Without it the macros below expand to nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+using namespace std;
+using namespace juce;
+
+#ifndef MBC_ENABLE_PROFILING
+ #define MBC_ENABLE_PROFILING 0
+#endif
+
+//==============================================================================
+// Wait-free histograms of the time spent in each stage of processBlock
+class StageProfiler
+{
+public:
+    enum Stage
+    {
+        coefficients = 0,
+        filtering,
+        compression,
+        summing,
+        numStages
+    };
+
+    struct Statistics
+    {
+        uint64 count;
+        double meanMicroseconds;
+        double p99Microseconds;
+        double maxMicroseconds;
+    };
+
+    StageProfiler() { reset(); }
+
+    static const char* getStageName(int stage)
+    {
+        static const char* const names[] = { "coefficients", "filtering", "compression", "summing" };
+        return names[jlimit(0, (int) numStages - 1, stage)];
+    }
+
+    // Audio thread: a single writer, so relaxed atomics are enough
+    void record(Stage stage, int64 ticks)
+    {
+        auto& histogram = histograms[stage];
+        const uint64 value = (uint64) jmax((int64) 0, ticks);
+
+        histogram.buckets[getBucket(value)].fetch_add(1, memory_order_relaxed);
+        histogram.count.fetch_add(1, memory_order_relaxed);
+        histogram.totalTicks.fetch_add(value, memory_order_relaxed);
+
+        if (value > histogram.maxTicks.load(memory_order_relaxed))
+            histogram.maxTicks.store(value, memory_order_relaxed);
+    }
+
+    // Any thread: mean, 99th percentile and maximum of a stage
+    Statistics getStatistics(Stage stage) const
+    {
+        const auto& histogram = histograms[stage];
+        const uint64 count = histogram.count.load(memory_order_relaxed);
+        const double microsecondsPerTick = 1.0e6 / (double) Time::getHighResolutionTicksPerSecond();
+
+        Statistics statistics { count, 0.0, 0.0, 0.0 };
+        if (count == 0)
+            return statistics;
+
+        statistics.meanMicroseconds = (double) histogram.totalTicks.load(memory_order_relaxed) / (double) count * microsecondsPerTick;
+        statistics.maxMicroseconds = (double) histogram.maxTicks.load(memory_order_relaxed) * microsecondsPerTick;
+
+        // The 99th percentile is the upper edge of the bucket holding it
+        const uint64 target = count - count / 100;
+        uint64 seen = 0;
+        for (int bucket = 0; bucket < numBuckets; bucket++)
+        {
+            seen += histogram.buckets[bucket].load(memory_order_relaxed);
+            if (seen >= target)
+            {
+                statistics.p99Microseconds = (double) getBucketUpperEdge(bucket) * microsecondsPerTick;
+                break;
+            }
+        }
+
+        statistics.p99Microseconds = jmin(statistics.p99Microseconds, statistics.maxMicroseconds);
+        return statistics;
+    }
+
+    // One line per stage, used by the editor and the offline tool
+    String getReport() const
+    {
+        String report;
+        for (int stage = 0; stage < numStages; stage++)
+        {
+            const auto statistics = getStatistics((Stage) stage);
+            report << getStageName(stage) << ": mean " << String(statistics.meanMicroseconds, 2)
+                   << " us, p99 " << String(statistics.p99Microseconds, 2)
+                   << " us, max " << String(statistics.maxMicroseconds, 2) << " us\n";
+        }
+        return report;
+    }
+
+    void reset()
+    {
+        for (auto& histogram : histograms)
+        {
+            for (auto& bucket : histogram.buckets)
+                bucket.store(0, memory_order_relaxed);
+
+            histogram.count.store(0, memory_order_relaxed);
+            histogram.totalTicks.store(0, memory_order_relaxed);
+            histogram.maxTicks.store(0, memory_order_relaxed);
+        }
+    }
+
+    // Times consecutive stages: each call to next() closes the stage that just ran
+    class Lap
+    {
+    public:
+        Lap(StageProfiler& profilerToUse) : profiler(profilerToUse), start(Time::getHighResolutionTicks()) {}
+
+        void next(Stage stage)
+        {
+            const int64 now = Time::getHighResolutionTicks();
+            profiler.record(stage, now - start);
+            start = now;
+        }
+
+    private:
+        StageProfiler& profiler;
+        int64 start;
+    };
+
+private:
+    // Four buckets per octave of ticks
+    static constexpr int bucketsPerOctave = 4;
+    static constexpr int numBuckets = 64 * bucketsPerOctave;
+
+    static int getBucket(uint64 ticks)
+    {
+        if (ticks < bucketsPerOctave)
+            return (int) ticks;
+
+        int octave = 63;
+        while ((ticks >> octave) == 0)
+            --octave;
+
+        return octave * bucketsPerOctave + (int) ((ticks >> (octave - 2)) & (bucketsPerOctave - 1));
+    }
+
+    static uint64 getBucketUpperEdge(int bucket)
+    {
+        if (bucket < bucketsPerOctave)
+            return (uint64) bucket;
+
+        const int octave = bucket / bucketsPerOctave;
+        const uint64 step = (uint64) 1 << (octave - 2);
+        return ((uint64) (bucketsPerOctave + bucket % bucketsPerOctave) + 1) * step;
+    }
+
+    struct Histogram
+    {
+        atomic<uint32> buckets[numBuckets];
+        atomic<uint64> count;
+        atomic<uint64> totalTicks;
+        atomic<uint64> maxTicks;
+    };
+
+    Histogram histograms[numStages];
+
+    JUCE_DECLARE_NON_COPYABLE (StageProfiler)
+};
+
+#if MBC_ENABLE_PROFILING
+ #define MBC_PROFILE_BEGIN(profiler)    StageProfiler::Lap profilerLap (profiler)
+ #define MBC_PROFILE_LAP(stage)         profilerLap.next (StageProfiler::stage)
+#else
+ #define MBC_PROFILE_BEGIN(profiler)
+ #define MBC_PROFILE_LAP(stage)
+#endif